@@ -0,0 +1,108 @@
+/**
+ * Plays random matches of every team size step by step and reports how long
+ * each attack phase took and what it allocated.
+ *
+ *     bench [MATCHES] [SEED]
+ *
+ * The allocation counts come from the replaced global new and delete of
+ * sources/Allocations.cpp, which this binary links and demo, simulate and
+ * the shared library do not. A warm-up pass runs first, so the counts are
+ * those of steady play; bench exits with 1 when any attack allocated.
+ */
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+using namespace std;
+
+#include "sources/Allocations.hpp"
+#include "sources/Latency.hpp"
+using namespace ariel;
+
+// Times the phases and charges their allocations at once.
+struct BenchObserver : NoObserver {
+    LatencyObserver latency;
+    AllocationObserver allocations;
+
+    explicit BenchObserver(AllocationTracker &tracker) : allocations(tracker) {}
+
+    void enter(Phase phase) {
+        allocations.enter(phase);
+        latency.enter(phase);
+    }
+    void leave(Phase phase) {
+        latency.leave(phase);
+        allocations.leave(phase);
+    }
+    void attackStarting(const Scenario &scenario, int side) {
+        allocations.attackStarting(scenario, side);
+        latency.attackStarting(scenario, side);
+    }
+    void attackFinished(const Scenario &scenario, int side) {
+        latency.attackFinished(scenario, side);
+        allocations.attackFinished(scenario, side);
+    }
+};
+
+static vector<Scenario> randomScenarios(size_t count, unsigned seed) {
+    mt19937 random(seed);
+    uniform_int_distribution<int> kind(0, 3);
+    uniform_real_distribution<double> coordinate(0, 60);
+    vector<Scenario> scenarios(count);
+    for (size_t i = 0; i < count; ++i) {
+        int members = 1 + (int) (i % MAX_MEMBERS);
+        scenarios[i].second = Roster(i / MAX_MEMBERS % 2 == 0 ? Ordering::CowboysFirst : Ordering::Insertion);
+        for (Roster *roster: {&scenarios[i].first, &scenarios[i].second}) {
+            for (int member = 0; member < members; ++member) {
+                roster->add(static_cast<Kind>(kind(random)), coordinate(random), coordinate(random));
+            }
+        }
+    }
+    return scenarios;
+}
+
+static bool parse(const char *text, unsigned long &value) {
+    const char *end = text + strlen(text);
+    auto [next, error] = from_chars(text, end, value);
+    return error == errc() && next == end;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long matches = 20000;
+    unsigned long seed = 38;
+    if (argc > 3 || (argc > 1 && !parse(argv[1], matches)) || (argc > 2 && !parse(argv[2], seed))) {
+        cerr << "usage: " << argv[0] << " [MATCHES] [SEED]" << endl;
+        return 2;
+    }
+    vector<Scenario> scenarios = randomScenarios(matches, (unsigned) seed);
+    vector<Scenario> played(scenarios.size());
+    {
+        AllocationTracker warmUp;
+        BenchObserver observer(warmUp);
+        for (size_t i = 0; i < scenarios.size() && i < 100; ++i) {
+            played[i] = scenarios[i];
+            Match::stepByStep(played[i], observer);
+        }
+    }
+    LatencyRecorder::instance().clear();
+    AllocationTracker tracker;
+    BenchObserver observer(tracker);
+    long rounds = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        played[i] = scenarios[i];
+        rounds += Match::stepByStep(played[i], observer).rounds;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << scenarios.size() << " matches, " << rounds << " rounds in " << seconds << "s\n\n"
+         << LatencyRecorder::instance().format() << '\n' << tracker.report();
+    for (int stage = 0; stage < STAGES; ++stage) {
+        if (tracker[stage].allocations != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
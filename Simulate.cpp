@@ -0,0 +1,121 @@
+/**
+ * Plays every scenario of a scenario file and writes one result line per
+ * scenario: its index, the winner, the rounds played and the survivors and
+ * health left on each side.
+ *
+ *     simulate SCENARIOS [RESULTS] [-j THREADS] [-c COLUMNS]
+ *
+ * Results go to standard output when no file is given. -c also writes them
+ * to a columnar result file, see sources/Results.hpp; RESULTS may then be
+ * /dev/null. See sources/ScenarioFile.hpp for the scenario formats.
+ */
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "sources/ScenarioFile.hpp"
+#include "sources/Results.hpp"
+
+using namespace ariel;
+
+static const char *winnerName(Winner winner) {
+    switch (winner) {
+        case Winner::First: return "first";
+        case Winner::Second: return "second";
+        case Winner::Undecided: return "undecided";
+    }
+    return "unknown";
+}
+
+static void writeResults(ostream &out, span<const Outcome> outcomes, size_t first) {
+    char line[128];
+    for (size_t i = 0; i < outcomes.size(); ++i) {
+        const Outcome &outcome = outcomes[i];
+        char *at = to_chars(line, line + sizeof line, first + i).ptr;
+        *at++ = ' ';
+        size_t name = strlen(winnerName(outcome.winner));
+        memcpy(at, winnerName(outcome.winner), name);
+        at += name;
+        for (int value: {outcome.rounds, outcome.aliveFirst, outcome.aliveSecond, outcome.healthFirst,
+                         outcome.healthSecond}) {
+            *at++ = ' ';
+            at = to_chars(at, line + sizeof line, value).ptr;
+        }
+        *at++ = '\n';
+        out.write(line, at - line);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    vector<string> files;
+    string columnsPath;
+    unsigned threads = 0;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            const char *count = argv[++i];
+            const char *end = count + strlen(count);
+            auto [next, error] = from_chars(count, end, threads);
+            usage = usage || error != errc() || next != end;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            columnsPath = argv[++i];
+        } else {
+            files.emplace_back(argv[i]);
+        }
+    }
+    if (usage || files.empty() || files.size() > 2) {
+        cerr << "usage: " << argv[0] << " SCENARIOS [RESULTS] [-j THREADS] [-c COLUMNS]" << endl;
+        return 2;
+    }
+    try {
+        auto start = chrono::steady_clock::now();
+        ScenarioFile scenarios(files[0]);
+        auto loaded = chrono::steady_clock::now();
+        ofstream file;
+        if (files.size() == 2) {
+            file.open(files[1], ios::binary);
+            if (!file) {
+                throw runtime_error("could not open result file " + files[1]);
+            }
+        }
+        ostream &out = files.size() == 2 ? file : cout;
+        unique_ptr<ResultWriter> columns;
+        if (!columnsPath.empty()) {
+            columns = make_unique<ResultWriter>(columnsPath);
+        }
+        // Played a block at a time so the final rosters never need more
+        // memory than one block, however large the file is.
+        span<const Scenario> all = scenarios.scenarios();
+        vector<Scenario> block;
+        vector<Outcome> outcomes;
+        for (size_t first = 0; first < all.size(); first += ResultWriter::DEFAULT_BLOCK_ROWS) {
+            span<const Scenario> starts = all.subspan(first, min(ResultWriter::DEFAULT_BLOCK_ROWS, all.size() - first));
+            block.assign(starts.begin(), starts.end());
+            outcomes.resize(block.size());
+            Match::playBatchInPlace(block, outcomes, threads);
+            writeResults(out, outcomes, first);
+            for (size_t i = 0; columns && i < block.size(); ++i) {
+                columns->append(ResultRow::of(first + i, starts[i], block[i], outcomes[i]));
+            }
+        }
+        if (columns) {
+            columns->close();
+        }
+        out.flush();
+        auto played = chrono::steady_clock::now();
+        cerr << all.size() << " scenarios: loaded in " << chrono::duration<double>(loaded - start).count()
+             << "s, played and written in " << chrono::duration<double>(played - loaded).count() << "s" << endl;
+    } catch (const exception &error) {
+        cerr << argv[0] << ": " << error.what() << endl;
+        return 1;
+    }
+    return 0;
+}
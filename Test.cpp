@@ -3,10 +3,46 @@
 #include "sources/YoungNinja.hpp"
 #include "sources/OldNinja.hpp"
 #include "sources/Team.hpp"
+#include "sources/Match.hpp"
+#include "sources/Evolution.hpp"
+#include "sources/OutcomeCache.hpp"
+#include "sources/Zobrist.hpp"
+#include "sources/FastForward.hpp"
+#include "sources/Volley.hpp"
+#include "sources/Endgame.hpp"
+#include "sources/EventEngine.hpp"
+#include "sources/Arena.hpp"
+#include "sources/ShardedBattle.hpp"
+#include "sources/ProcessBatch.hpp"
+#include "sources/PerfCounters.hpp"
+#include "sources/Latency.hpp"
+#include "sources/Allocations.hpp"
+#include "sources/Tracer.hpp"
+#include "sources/Fuzzer.hpp"
+#include "sources/CowboyNinja.h"
+#include "sources/ScenarioFile.hpp"
+#include "sources/Results.hpp"
+#include "sources/Tables.hpp"
+#include "sources/Turns.hpp"
+#include "sources/Snapshot.hpp"
+#include "sources/Commands.hpp"
+#include "sources/TickServer.hpp"
+#include "sources/InlineVector.hpp"
 #include "doctest.h"
 #include <stdexcept>
 #include <iostream>
 #include <string>
+#include <random>
+#include <thread>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <new>
+#include <atomic>
+#include <csignal>
+#include <unistd.h>
+#include <cmath>
+#include <cstring>
 
 using namespace std;
 using namespace ariel;
@@ -277,3 +313,1475 @@ TEST_CASE("Multiple Attacks and Hits") {
     INFO("It's a tie!");
 }
 
+TEST_CASE("Roster keeps the Team and Team2 traversal order") {
+    Roster grouped(Ordering::CowboysFirst);
+    CHECK(grouped.add(Kind::OldNinja, 0, 0) == 0);
+    CHECK(grouped.add(Kind::Cowboy, 1, 1) == 0);
+    CHECK(grouped.add(Kind::YoungNinja, 2, 2) == 2);
+    CHECK(grouped.add(Kind::Cowboy, 3, 3) == 1);
+    CHECK(grouped.members[0].x == 1);
+    CHECK(grouped.members[1].x == 3);
+    CHECK(grouped.members[(size_t) grouped.leader].kind == Kind::OldNinja);
+
+    Roster inserted(Ordering::Insertion);
+    inserted.add(Kind::OldNinja, 0, 0);
+    inserted.add(Kind::Cowboy, 1, 1);
+    CHECK(inserted.members[1].isCowboy());
+    CHECK(inserted.leader == 0);
+    for (int i = 2; i < MAX_MEMBERS; ++i) {
+        inserted.add(Kind::Cowboy, i, i);
+    }
+    CHECK_THROWS_AS(inserted.add(Kind::Cowboy, 0, 0), std::runtime_error);
+}
+
+TEST_CASE("Match plays a cowboy against an adjacent ninja") {
+    Scenario scenario;
+    scenario.first.add(Kind::Cowboy, 0, 0);
+    scenario.second.add(Kind::YoungNinja, 0.5, 0);
+    Outcome outcome = Match::play(scenario);
+    CHECK(outcome.winner == Winner::Second);
+    CHECK(outcome.rounds == 3);
+    CHECK(outcome.healthSecond == 70);
+    CHECK(outcome.aliveFirst == 0);
+}
+
+TEST_CASE("Batch play matches single matches") {
+    std::vector<Scenario> scenarios;
+    for (int i = 0; i < 37; ++i) {
+        Scenario scenario;
+        scenario.first.add(Kind::Cowboy, i, 0);
+        scenario.first.add(Kind::TrainedNinja, 0, i);
+        scenario.second = Roster(Ordering::Insertion);
+        scenario.second.add(Kind::OldNinja, 20, 20 - i);
+        scenario.second.add(Kind::Cowboy, 30, i);
+        scenarios.push_back(scenario);
+    }
+    std::vector<Outcome> outcomes(scenarios.size());
+    Match::playBatch(scenarios, outcomes, 4);
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        Outcome single = Match::play(scenarios[i]);
+        CHECK(outcomes[i].winner == single.winner);
+        CHECK(outcomes[i].rounds == single.rounds);
+    }
+}
+
+TEST_CASE("Evolution improves and resumes from a checkpoint") {
+    Roster opponent;
+    opponent.add(Kind::Cowboy, 50, 50);
+    opponent.add(Kind::OldNinja, 40, 60);
+    opponent.add(Kind::YoungNinja, 60, 40);
+    EvolutionConfig config;
+    config.populationSize = 16;
+    config.memberCap = 4;
+    config.threads = 2;
+    config.seed = 7;
+
+    Evolution evolution(config, {opponent});
+    evolution.run(2);
+    double early = evolution.best().fitness;
+    evolution.saveCheckpoint("evolution_checkpoint.txt");
+    evolution.run(3);
+    CHECK(evolution.best().fitness >= early);
+    CHECK(evolution.best().size <= 4);
+
+    Evolution resumed(config, {opponent});
+    resumed.loadCheckpoint("evolution_checkpoint.txt");
+    CHECK(resumed.generation() == 2);
+    resumed.run(3);
+    CHECK(resumed.best().fitness == evolution.best().fitness);
+
+    // A truncated checkpoint is rejected and leaves the evolution untouched.
+    evolution.saveCheckpoint("evolution_checkpoint.txt");
+    std::stringstream whole;
+    whole << std::ifstream("evolution_checkpoint.txt").rdbuf();
+    std::string text = whole.str();
+    std::ofstream("evolution_checkpoint.txt") << text.substr(0, text.size() - 20);
+    Evolution fresh(config, {opponent});
+    fresh.run(1);
+    Genome champion = fresh.best();
+    std::vector<Genome> before = fresh.candidates();
+    CHECK_THROWS_AS(fresh.loadCheckpoint("evolution_checkpoint.txt"), std::runtime_error);
+    CHECK(fresh.generation() == 1);
+    CHECK(fresh.best().fitness == champion.fitness);
+    CHECK(fresh.best().size == champion.size);
+    for (size_t i = 0; i < before.size(); ++i) {
+        CHECK(fresh.candidates()[i].fitness == before[i].fitness);
+        CHECK(fresh.candidates()[i].size == before[i].size);
+    }
+    std::remove("evolution_checkpoint.txt");
+}
+
+TEST_CASE("Outcome cache shares entries between shifted formations and persists") {
+    Scenario scenario;
+    scenario.first.add(Kind::Cowboy, 10, 20);
+    scenario.first.add(Kind::OldNinja, 30, 5);
+    scenario.second.add(Kind::TrainedNinja, 40, 40);
+    Scenario shifted = scenario;
+    for (Roster *roster: {&shifted.first, &shifted.second}) {
+        for (int i = 0; i < roster->size; ++i) {
+            roster->members[(size_t) i].x += 64;
+            roster->members[(size_t) i].y += 128;
+        }
+    }
+    Scenario swapped{scenario.second, scenario.first};
+    CHECK(OutcomeCache::key(scenario) == OutcomeCache::key(shifted));
+    CHECK_FALSE(OutcomeCache::key(scenario) == OutcomeCache::key(swapped));
+
+    std::remove("outcome_cache.bin");
+    Outcome played{};
+    {
+        OutcomeCache cache("outcome_cache.bin", 64);
+        played = cache.play(scenario);
+        CHECK(cache.size() == 1);
+        cache.play(shifted);
+        CHECK(cache.size() == 1);
+        std::vector<Scenario> batch{scenario, swapped, shifted};
+        std::vector<Outcome> outcomes(batch.size());
+        cache.playBatch(batch, outcomes);
+        CHECK(cache.size() == 2);
+        CHECK(outcomes[1].rounds == Match::play(OutcomeCache::canonical(swapped)).rounds);
+    }
+    OutcomeCache reopened("outcome_cache.bin", 0);
+    Outcome stored{};
+    CHECK(reopened.capacity() == 64);
+    REQUIRE(reopened.find(OutcomeCache::key(shifted), stored));
+    CHECK(stored.winner == played.winner);
+    CHECK(stored.rounds == played.rounds);
+    std::remove("outcome_cache.bin");
+
+    // A header claiming no slots must not be trusted on reopen.
+    std::uint64_t corrupt[3] = {0x4e4a4143484531ULL, 0, 0};
+    std::ofstream("outcome_cache.bin", std::ios::binary).write(reinterpret_cast<const char *>(corrupt), sizeof(corrupt));
+    CHECK_THROWS_AS(OutcomeCache("outcome_cache.bin", 0), std::runtime_error);
+    std::ofstream("outcome_cache.bin", std::ios::binary).write("short", 5);
+    CHECK_THROWS_AS(OutcomeCache("outcome_cache.bin", 0), std::runtime_error);
+    std::remove("outcome_cache.bin");
+}
+
+TEST_CASE("Zobrist hash follows attacks incrementally") {
+    Scenario scenario;
+    scenario.first.add(Kind::YoungNinja, 0, 0);
+    scenario.first.add(Kind::Cowboy, 5, 5);
+    scenario.second.add(Kind::OldNinja, 20, 3);
+    scenario.second.add(Kind::Cowboy, 25, 0);
+    ZobristObserver observer(scenario);
+    std::uint64_t start = observer.value();
+    while (scenario.first.stillAlive() > 0 && scenario.second.stillAlive() > 0) {
+        Match::attack(scenario.first, scenario.second, observer);
+        CHECK(observer.value() == Zobrist::hash(scenario));
+        Match::attack(scenario.second, scenario.first, observer);
+        CHECK(observer.value() == Zobrist::hash(scenario));
+    }
+    CHECK(observer.value() != start);
+    observer.toggleSideToMove();
+    CHECK(observer.value() == (Zobrist::hash(scenario) ^ Zobrist::SIDE_TO_MOVE));
+}
+
+TEST_CASE("Transposition table stores and rejects entries") {
+    TranspositionTable table(1000);
+    CHECK(table.capacity() == 1024);
+    std::uint64_t data = 0;
+    CHECK_FALSE(table.probe(12345, data));
+    table.store(12345, 77);
+    REQUIRE(table.probe(12345, data));
+    CHECK(data == 77);
+    CHECK_FALSE(table.probe(12345 + 1024, data));
+    table.store(12345 + 1024, 5);
+    CHECK_FALSE(table.probe(12345, data));
+    table.clear();
+    CHECK_FALSE(table.probe(12345 + 1024, data));
+}
+
+static const MatchOptions STEP_BY_STEP{MAX_ROUNDS, false, false, false};
+
+static Scenario randomScenario(std::mt19937 &random, int members, double spread) {
+    std::uniform_int_distribution<int> kind(0, 3);
+    std::uniform_int_distribution<int> size(1, members);
+    std::uniform_real_distribution<double> coordinate(0, spread);
+    Scenario scenario;
+    scenario.second = Roster(random() % 2 == 0 ? Ordering::CowboysFirst : Ordering::Insertion);
+    for (Roster *roster: {&scenario.first, &scenario.second}) {
+        for (int i = size(random); i > 0; --i) {
+            roster->add(static_cast<Kind>(kind(random)), coordinate(random), coordinate(random));
+        }
+    }
+    return scenario;
+}
+
+TEST_CASE("Closed form cowboy volleys match shooting one round at a time") {
+    for (int bullets = 0; bullets <= COWBOY_BULLETS; ++bullets) {
+        int fired = 0;
+        int left = bullets;
+        for (int rounds = 1; rounds < 40; ++rounds) {
+            if (left > 0) {
+                fired++;
+                left--;
+            } else {
+                left = COWBOY_BULLETS;
+            }
+            CHECK(FastForward::shots(rounds, bullets) == fired);
+            CHECK(FastForward::bulletsAfter(rounds, bullets) == left);
+        }
+    }
+}
+
+TEST_CASE("Skipping quiet rounds is exact") {
+    std::mt19937 random(29);
+    int skipped = 0;
+    for (int game = 0; game < 300; ++game) {
+        Scenario fast = randomScenario(random, 5, game % 2 == 0 ? 200 : 30);
+        Scenario slow = fast;
+        int rounds = 0;
+        while (rounds < MAX_ROUNDS && fast.first.stillAlive() > 0 && fast.second.stillAlive() > 0) {
+            int quiet = FastForward::skip(fast, MAX_ROUNDS - rounds);
+            for (int i = 0; i < quiet; ++i) {
+                Match::attack(slow.first, slow.second);
+                Match::attack(slow.second, slow.first);
+            }
+            skipped += quiet;
+            REQUIRE(Zobrist::hash(fast) == Zobrist::hash(slow));
+            for (Scenario *scenario: {&fast, &slow}) {
+                Match::attack(scenario->first, scenario->second);
+                Match::attack(scenario->second, scenario->first);
+            }
+            rounds += quiet + 1;
+        }
+        Scenario start = randomScenario(random, 5, 100);
+        Outcome skipping = Match::play(start, MatchOptions{MAX_ROUNDS, true, false, false});
+        Outcome stepping = Match::play(start, STEP_BY_STEP);
+        CHECK(skipping.winner == stepping.winner);
+        CHECK(skipping.rounds == stepping.rounds);
+        CHECK(skipping.healthFirst == stepping.healthFirst);
+        CHECK(skipping.healthSecond == stepping.healthSecond);
+    }
+    CHECK(skipped > 300);
+
+    // Two ninjas walking towards each other close 22 units a round, so the
+    // first 45 rounds of 1000 units are quiet in one go.
+    Scenario apart;
+    apart.first.add(Kind::OldNinja, 0, 0);
+    apart.second.add(Kind::YoungNinja, 1000, 0);
+    Scenario stepped = apart;
+    int quiet = FastForward::skip(apart, MAX_ROUNDS);
+    CHECK(quiet >= 40);
+    for (int i = 0; i < quiet; ++i) {
+        Match::attack(stepped.first, stepped.second);
+        Match::attack(stepped.second, stepped.first);
+    }
+    CHECK(Zobrist::hash(apart) == Zobrist::hash(stepped));
+}
+
+TEST_CASE("Volley finds the killing blow") {
+    Roster attackers(Ordering::Insertion);
+    attackers.add(Kind::Cowboy, 0, 0);
+    attackers.add(Kind::OldNinja, 10, 10.5);
+    attackers.add(Kind::Cowboy, 0, 0);
+    attackers.add(Kind::YoungNinja, 50, 50);
+    attackers.add(Kind::Cowboy, 0, 0);
+    attackers.members[2].bullets = 0;
+    Fighter victim{10, 10, 55, 0, Kind::TrainedNinja};
+    Volley volley(attackers);
+    CHECK(volley.killer(victim, 0) == 4);
+    CHECK(volley.killer(victim, 1) == -1);
+    victim.health = 50;
+    CHECK(volley.killer(victim, 0) == 1);
+    victim.health = 10;
+    CHECK(volley.killer(victim, 0) == 0);
+    CHECK(volley.killer(victim, 2) == 4);
+    CHECK(volley.bulletsUsed(0, 5) == 2);
+}
+
+TEST_CASE("Volley attacks match the sequential attack") {
+    std::mt19937 random(30);
+    for (int game = 0; game < 300; ++game) {
+        Scenario sequential = randomScenario(random, MAX_MEMBERS, game % 3 == 0 ? 3 : 40);
+        Scenario volleys = sequential;
+        for (int round = 0; round < 500 && sequential.first.stillAlive() > 0 && sequential.second.stillAlive() > 0; ++round) {
+            Match::attack(sequential.first, sequential.second);
+            Volley::attack(volleys.first, volleys.second);
+            Match::attack(sequential.second, sequential.first);
+            Volley::attack(volleys.second, volleys.first);
+            REQUIRE(Zobrist::hash(sequential) == Zobrist::hash(volleys));
+        }
+    }
+}
+
+TEST_CASE("Endgame table matches turn by turn play over its whole domain") {
+    const Endgame &endgame = Endgame::instance();
+    const Kind ninjas[] = {Kind::YoungNinja, Kind::TrainedNinja, Kind::OldNinja};
+    auto check = [&](Fighter first, Fighter second) {
+        Scenario scenario;
+        scenario.first.add(first);
+        scenario.second.add(second);
+        Outcome expected = Match::play(scenario, STEP_BY_STEP);
+        Outcome outcome{};
+        REQUIRE(endgame.resolve(scenario, 0, MAX_ROUNDS, outcome));
+        CHECK(outcome.winner == expected.winner);
+        CHECK(outcome.rounds == expected.rounds);
+        CHECK(outcome.healthFirst == expected.healthFirst);
+        CHECK(outcome.healthSecond == expected.healthSecond);
+    };
+    for (int one = 0; one < Endgame::DESCRIPTORS; ++one) {
+        for (int other = 0; other < Endgame::DESCRIPTORS; ++other) {
+            for (int hits = 1; hits <= Endgame::MAX_HITS; ++hits) {
+                for (int taken = 1; taken <= Endgame::MAX_HITS; ++taken) {
+                    bool firstShoots = one <= COWBOY_BULLETS;
+                    bool secondShoots = other <= COWBOY_BULLETS;
+                    int firstDamage = firstShoots ? BULLET_DAMAGE : SLASH_DAMAGE;
+                    int secondDamage = secondShoots ? BULLET_DAMAGE : SLASH_DAMAGE;
+                    Kind firstKind = firstShoots ? Kind::Cowboy : ninjas[(hits + taken) % 3];
+                    Kind secondKind = secondShoots ? Kind::Cowboy : ninjas[(hits * taken) % 3];
+                    int firstSlash = one - COWBOY_BULLETS;
+                    int secondSlash = other - COWBOY_BULLETS;
+                    double gap = 0.5;
+                    if (!firstShoots && !secondShoots) {
+                        double closing = speedOf(firstKind) + speedOf(secondKind);
+                        if (firstSlash == secondSlash) {
+                            gap += (firstSlash - 1) * closing;
+                        } else if (firstSlash == secondSlash + 1) {
+                            gap += (secondSlash - 1) * closing + speedOf(firstKind);
+                        } else {
+                            continue;
+                        }
+                    } else if (!firstShoots) {
+                        gap += (firstSlash - 1) * speedOf(firstKind);
+                    } else if (!secondShoots) {
+                        gap += (secondSlash - 1) * speedOf(secondKind);
+                    }
+                    for (int spare = 0; spare < 2; ++spare) {
+                        Fighter first{0, 0, taken * secondDamage - spare * (secondDamage - 1), firstShoots ? one : 0, firstKind};
+                        Fighter second{gap, 0, hits * firstDamage - spare * (firstDamage - 1), secondShoots ? other : 0, secondKind};
+                        check(first, second);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Endgame resolution keeps match results exact") {
+    std::mt19937 random(31);
+    for (int game = 0; game < 500; ++game) {
+        Scenario scenario = randomScenario(random, 3, 300);
+        Outcome fast = Match::play(scenario);
+        Outcome slow = Match::play(scenario, STEP_BY_STEP);
+        CHECK(fast.winner == slow.winner);
+        CHECK(fast.rounds == slow.rounds);
+        CHECK(fast.healthFirst == slow.healthFirst);
+        CHECK(fast.healthSecond == slow.healthSecond);
+    }
+
+    // The ninja would walk for about a million rounds but the cowboy kills it
+    // in 11, so the approach stops in round 12.
+    Scenario far;
+    far.first.add(Kind::Cowboy, 0, 0);
+    far.second.add(Kind::YoungNinja, 1e7, 0);
+    Duelist one{};
+    Duelist other{};
+    CHECK(Endgame::approach(far.first.members[0], far.second.members[0], one, other, MAX_ROUNDS));
+    CHECK(other.firstSlash == one.roundsToKill(far.second.members[0].health) + 1);
+    Outcome resolved{};
+    REQUIRE(Endgame::instance().resolve(far, 0, MAX_ROUNDS, resolved));
+    Outcome stepped = Match::play(far, STEP_BY_STEP);
+    CHECK(resolved.winner == stepped.winner);
+    CHECK(resolved.rounds == stepped.rounds);
+    CHECK(resolved.healthFirst == stepped.healthFirst);
+    CHECK(resolved.healthSecond == stepped.healthSecond);
+}
+
+TEST_CASE("Pairing heap pops in order") {
+    PairingHeap<int> heap;
+    std::mt19937 random(32);
+    std::vector<int> values;
+    for (int i = 0; i < 500; ++i) {
+        values.push_back((int) (random() % 1000));
+        heap.push(values.back());
+        if (i % 3 == 0) {
+            std::sort(values.begin(), values.end());
+            CHECK(heap.pop() == values.front());
+            values.erase(values.begin());
+        }
+    }
+    std::sort(values.begin(), values.end());
+    for (int value: values) {
+        CHECK(heap.pop() == value);
+    }
+    CHECK(heap.empty());
+}
+
+TEST_CASE("Event engine reproduces lock step play") {
+    std::mt19937 random(33);
+    for (int game = 0; game < 300; ++game) {
+        Scenario scenario = randomScenario(random, MAX_MEMBERS, game % 2 == 0 ? 5 : 80);
+        Outcome expected = Match::play(scenario, STEP_BY_STEP);
+        for (Schedule schedule: {Schedule::LockStep, Schedule::Sparse}) {
+            Battle battle(scenario);
+            EventEngine engine(schedule);
+            Outcome outcome = engine.play(battle);
+            CHECK(outcome.winner == expected.winner);
+            CHECK(outcome.rounds == expected.rounds);
+            CHECK(outcome.healthFirst == expected.healthFirst);
+            CHECK(outcome.healthSecond == expected.healthSecond);
+        }
+    }
+}
+
+TEST_CASE("Sparse schedule skips quiet turns of large armies") {
+    std::mt19937 random(34);
+    std::uniform_real_distribution<double> coordinate(0, 1000);
+    std::vector<Fighter> cowboys;
+    std::vector<Fighter> ninjas;
+    for (int i = 0; i < 4; ++i) {
+        cowboys.push_back(Fighter{coordinate(random), coordinate(random), COWBOY_HEALTH, COWBOY_BULLETS, Kind::Cowboy});
+    }
+    for (int i = 0; i < 400; ++i) {
+        ninjas.push_back(Fighter{coordinate(random) + 3000, coordinate(random), 150, 0, Kind::OldNinja});
+    }
+    Battle lockStep(Army(cowboys, Ordering::CowboysFirst), Army(ninjas, Ordering::Insertion));
+    Battle sparse = lockStep;
+    EventEngine every(Schedule::LockStep);
+    EventEngine events(Schedule::Sparse);
+    Outcome expected = every.play(lockStep);
+    Outcome outcome = events.play(sparse);
+    CHECK(outcome.winner == expected.winner);
+    CHECK(outcome.rounds == expected.rounds);
+    CHECK(outcome.healthFirst == expected.healthFirst);
+    CHECK(outcome.healthSecond == expected.healthSecond);
+    CHECK(events.events() * 3 < every.events() * 2);
+}
+
+TEST_CASE("Sparse schedule sleeps through walks and long duels") {
+    // The first army's ninjas walk a long way to the victim its leader
+    // picks while both sides' cowboys trade shots into deep health pools, so
+    // nearly every turn passes without an event.
+    std::vector<Fighter> first{Fighter{600, 0, 10000, COWBOY_BULLETS, Kind::Cowboy},
+                               Fighter{1, 0, 10000, COWBOY_BULLETS, Kind::Cowboy},
+                               Fighter{300, 200, 10000, 0, Kind::YoungNinja},
+                               Fighter{300, 210, 10000, 0, Kind::YoungNinja},
+                               Fighter{290, 190, 10000, 0, Kind::TrainedNinja}};
+    std::vector<Fighter> second{Fighter{0, 0, 10000, COWBOY_BULLETS, Kind::Cowboy},
+                                Fighter{500, 0, 3000, COWBOY_BULLETS, Kind::Cowboy}};
+    Battle lockStep(Army(first, Ordering::CowboysFirst), Army(second, Ordering::CowboysFirst));
+    Battle sparse = lockStep;
+    EventEngine every(Schedule::LockStep);
+    EventEngine events(Schedule::Sparse);
+    Outcome expected = every.play(lockStep);
+    Outcome outcome = events.play(sparse);
+    CHECK(expected.winner == Winner::First);
+    CHECK(outcome.winner == expected.winner);
+    CHECK(outcome.rounds == expected.rounds);
+    CHECK(outcome.aliveFirst == expected.aliveFirst);
+    CHECK(outcome.healthFirst == expected.healthFirst);
+    CHECK(outcome.healthSecond == expected.healthSecond);
+    CHECK(every.events() == (size_t) 2 * (size_t) expected.rounds - 1);
+    CHECK(events.events() * 10 < every.events());
+    for (size_t i = 0; i < first.size(); ++i) {
+        CHECK(sparse.first.members[i].x == lockStep.first.members[i].x);
+        CHECK(sparse.first.members[i].y == lockStep.first.members[i].y);
+    }
+}
+
+TEST_CASE("Two team arena plays like a match") {
+    std::mt19937 random(35);
+    for (int game = 0; game < 300; ++game) {
+        Scenario scenario = randomScenario(random, MAX_MEMBERS, game % 2 == 0 ? 5 : 80);
+        Outcome expected = Match::play(scenario, STEP_BY_STEP);
+        Arena arena({Army(scenario.first), Army(scenario.second)});
+        ArenaOutcome outcome = arena.play();
+        CHECK(outcome.rounds == expected.rounds);
+        CHECK(outcome.winner == (expected.winner == Winner::Undecided ? -1 : (int) expected.winner));
+        CHECK(arena.team(0).totalHealth() == expected.healthFirst);
+        CHECK(arena.team(1).totalHealth() == expected.healthSecond);
+    }
+}
+
+TEST_CASE("Arena spatial index picks the same victims as a full scan") {
+    std::mt19937 random(36);
+    std::uniform_int_distribution<int> kind(0, 3);
+    std::uniform_real_distribution<double> coordinate(0, 400);
+    std::vector<Army> teams;
+    for (int team = 0; team < 60; ++team) {
+        teams.emplace_back(team % 2 == 0 ? Ordering::CowboysFirst : Ordering::Insertion);
+        double x = coordinate(random);
+        double y = coordinate(random);
+        for (int i = 0; i < 8; ++i) {
+            teams.back().add(static_cast<Kind>(kind(random)), x + coordinate(random) / 20, y + coordinate(random) / 20);
+        }
+    }
+    Arena indexed(teams);
+    Arena scanned(teams, 1e9);
+    CHECK(indexed.spatialIndex().cellCount() > 1);
+    CHECK(scanned.spatialIndex().cellCount() == 1);
+    ArenaOutcome fast = indexed.play();
+    ArenaOutcome slow = scanned.play();
+    CHECK(fast.winner >= 0);
+    CHECK(fast.winner == slow.winner);
+    CHECK(fast.rounds == slow.rounds);
+    CHECK(fast.alive == slow.alive);
+    for (int team = 0; team < indexed.teams(); ++team) {
+        CHECK(indexed.team(team).totalHealth() == scanned.team(team).totalHealth());
+    }
+}
+
+TEST_CASE("Sharded battles match lock step play on any number of threads") {
+    std::mt19937 random(37);
+    std::uniform_int_distribution<int> kind(0, 3);
+    std::uniform_real_distribution<double> coordinate(0, 600);
+    Battle battle{Army(Ordering::CowboysFirst), Army(Ordering::Insertion)};
+    for (Army *army: {&battle.first, &battle.second}) {
+        std::vector<Fighter> fighters;
+        for (int i = 0; i < 1500; ++i) {
+            Kind chosen = static_cast<Kind>(kind(random));
+            fighters.push_back(Fighter{coordinate(random), coordinate(random), startingHealth(chosen),
+                                       chosen == Kind::Cowboy ? COWBOY_BULLETS : 0, chosen});
+        }
+        *army = Army(fighters, army->ordering, 7);
+    }
+    Battle expected = battle;
+    EventEngine engine(Schedule::LockStep);
+    Outcome reference = engine.play(expected);
+    for (unsigned threads: {1U, 3U, 8U}) {
+        ShardedBattle sharded(battle, threads);
+        Outcome outcome = sharded.play();
+        CHECK(outcome.winner == reference.winner);
+        CHECK(outcome.rounds == reference.rounds);
+        CHECK(outcome.aliveFirst == reference.aliveFirst);
+        CHECK(outcome.aliveSecond == reference.aliveSecond);
+        CHECK(outcome.healthFirst == reference.healthFirst);
+        CHECK(outcome.healthSecond == reference.healthSecond);
+        bool same = true;
+        for (size_t i = 0; i < expected.second.members.size(); ++i) {
+            const Fighter &one = sharded.second().members[i];
+            const Fighter &other = expected.second.members[i];
+            same = same && one.x == other.x && one.y == other.y && one.health == other.health;
+        }
+        CHECK(same);
+    }
+}
+
+TEST_CASE("Forked workers play a batch like threads do") {
+    std::mt19937 random(38);
+    std::vector<Scenario> scenarios;
+    for (int i = 0; i < 400; ++i) {
+        scenarios.push_back(randomScenario(random, MAX_MEMBERS, 60));
+    }
+    std::vector<Outcome> expected(scenarios.size());
+    Match::playBatch(scenarios, expected, 1);
+    std::vector<Outcome> outcomes(scenarios.size());
+    CHECK(ProcessBatch::play(scenarios, outcomes, ProcessOptions{3, 7, {}}) == 0);
+    bool same = true;
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        same = same && outcomes[i].winner == expected[i].winner && outcomes[i].rounds == expected[i].rounds &&
+               outcomes[i].healthFirst == expected[i].healthFirst && outcomes[i].healthSecond == expected[i].healthSecond;
+    }
+    CHECK(same);
+    CHECK_THROWS_AS(ProcessBatch::play(scenarios, std::span<Outcome>(outcomes).first(10)), std::invalid_argument);
+}
+
+TEST_CASE("Forked workers that run out of time only lose their own scenario") {
+    std::mt19937 random(39);
+    std::vector<Scenario> scenarios;
+    for (int i = 0; i < 60; ++i) {
+        scenarios.push_back(randomScenario(random, MAX_MEMBERS, 100000));
+    }
+    std::vector<Outcome> expected(scenarios.size());
+    Match::playBatch(scenarios, expected, 1, STEP_BY_STEP);
+    std::vector<Outcome> outcomes(scenarios.size());
+    size_t failed = ProcessBatch::play(scenarios, outcomes, ProcessOptions{2, 5, std::chrono::microseconds(10)},
+                                       STEP_BY_STEP);
+    size_t marked = 0;
+    bool rest = true;
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        if (outcomes[i].rounds == ProcessBatch::FAILED_ROUNDS) {
+            marked++;
+        } else {
+            rest = rest && outcomes[i].winner == expected[i].winner && outcomes[i].rounds == expected[i].rounds;
+        }
+    }
+    CHECK(failed == marked);
+    CHECK(failed > 0);
+    CHECK(rest);
+}
+
+TEST_CASE("Forked workers killed at any moment lose nothing but their scenario") {
+    std::mt19937 random(35);
+    std::vector<Scenario> scenarios;
+    for (int i = 0; i < 4000; ++i) {
+        scenarios.push_back(randomScenario(random, 3, 10));
+    }
+    std::vector<Outcome> expected(scenarios.size());
+    Match::playBatch(scenarios, expected, 1);
+    std::vector<Outcome> outcomes(scenarios.size(), Outcome{Winner::Undecided, -2, 0, 0, 0, 0});
+    // Ranges of one scenario make the moment between taking a range off
+    // the ring and starting on it a large share of a worker's time.
+    std::atomic<bool> done{false};
+    std::string children = "/proc/" + std::to_string(::getpid()) + "/task/" + std::to_string(::getpid()) + "/children";
+    std::thread killer([&] {
+        while (!done.load()) {
+            pid_t worker = 0;
+            if (std::ifstream(children) >> worker) {
+                ::kill(worker, SIGKILL);
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(300));
+        }
+    });
+    size_t failed = ProcessBatch::play(scenarios, outcomes, ProcessOptions{2, 1, {}});
+    done.store(true);
+    killer.join();
+    size_t marked = 0;
+    bool rest = true;
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        if (outcomes[i].rounds == ProcessBatch::FAILED_ROUNDS) {
+            marked++;
+        } else {
+            rest = rest && outcomes[i].winner == expected[i].winner && outcomes[i].rounds == expected[i].rounds;
+        }
+    }
+    CHECK(failed == marked);
+    CHECK(rest);
+}
+
+TEST_CASE("Phase counters observe every action without changing the match") {
+    static_assert(!PhaseObserver<NoObserver>);
+    static_assert(PhaseObserver<PhaseCounters>);
+    std::mt19937 random(40);
+    PerfCounters counters;
+    PhaseCounters total(counters);
+    for (int game = 0; game < 50; ++game) {
+        Scenario scenario = randomScenario(random, MAX_MEMBERS, 40);
+        PhaseCounters phases(counters);
+        Scenario played = scenario;
+        Outcome outcome = Match::stepByStep(played, phases);
+        Outcome expected = Match::play(scenario, STEP_BY_STEP);
+        CHECK(outcome.winner == expected.winner);
+        CHECK(outcome.rounds == expected.rounds);
+        CHECK(outcome.healthFirst == expected.healthFirst);
+        total += phases;
+    }
+    CHECK(total.count(Phase::Shoot) > 0);
+    CHECK(total.count(Phase::Slash) > 0);
+    CHECK(total.count(Phase::Move) > 0);
+    CHECK(total.count(Phase::Victim) >= total.count(Phase::Leader));
+    if (counters.available()) {
+        CHECK(total[Phase::Move].instructions > 0);
+    } else {
+        CHECK(total[Phase::Move].cycles == 0);
+    }
+    CHECK(total.report().find("slash") != std::string::npos);
+}
+
+TEST_CASE("Latency histogram percentiles stay within a bucket of the truth") {
+    LatencyHistogram histogram;
+    for (std::uint64_t value = 1; value <= 100000; ++value) {
+        histogram.record(value);
+    }
+    CHECK(histogram.count() == 100000);
+    for (double fraction: {0.5, 0.9, 0.99, 0.999}) {
+        double truth = fraction * 100000;
+        CHECK(std::abs((double) histogram.percentile(fraction) - truth) <= truth * 0.035);
+    }
+    for (size_t bucket = 1; bucket < LatencyHistogram::BUCKETS; ++bucket) {
+        CHECK(LatencyHistogram::lowest(bucket) == LatencyHistogram::highest(bucket - 1) + 1);
+        CHECK(LatencyHistogram::bucketOf(LatencyHistogram::lowest(bucket)) == bucket);
+    }
+}
+
+TEST_CASE("Latency recorder merges the buffers of every thread") {
+    LatencyRecorder &recorder = LatencyRecorder::instance();
+    recorder.clear();
+    auto work = [](unsigned seed) {
+        std::mt19937 random(seed);
+        for (int game = 0; game < 40; ++game) {
+            Scenario scenario = randomScenario(random, MAX_MEMBERS, 40);
+            LatencyObserver observer;
+            Scenario played = scenario;
+            Outcome outcome = Match::stepByStep(played, observer);
+            Outcome expected = Match::play(scenario, STEP_BY_STEP);
+            if (outcome.rounds != expected.rounds || outcome.winner != expected.winner) {
+                throw std::logic_error("timing changed the match");
+            }
+        }
+    };
+    std::thread other(work, 41U);
+    work(42U);
+    other.join();
+    std::vector<LatencyRow> rows = recorder.report();
+    CHECK(!rows.empty());
+    bool turns = false;
+    bool ordered = true;
+    for (const LatencyRow &row: rows) {
+        turns = turns || row.stage == TURN_STAGE;
+        ordered = ordered && row.p50 <= row.p90 && row.p90 <= row.p99 && row.p99 <= row.p999;
+    }
+    CHECK(turns);
+    CHECK(ordered);
+    std::uint64_t shoot = 0;
+    for (int size = 0; size <= MAX_MEMBERS; ++size) {
+        for (Ordering ordering: {Ordering::CowboysFirst, Ordering::Insertion}) {
+            shoot += recorder.merged((int) Phase::Shoot, size, ordering).count();
+        }
+    }
+    CHECK(shoot > 0);
+    CHECK(recorder.format().find("Team2") != std::string::npos);
+
+    // Finished threads hand their buffers on to the next ones.
+    size_t buffers = recorder.bufferCount();
+    recorder.clear();
+    for (unsigned round = 0; round < 3; ++round) {
+        std::thread again(work, 43U + round);
+        again.join();
+    }
+    CHECK(recorder.bufferCount() == buffers);
+    std::uint64_t turnsAfter = 0;
+    for (int size = 0; size <= MAX_MEMBERS; ++size) {
+        turnsAfter += recorder.merged(TURN_STAGE, size, Ordering::CowboysFirst).count();
+        turnsAfter += recorder.merged(TURN_STAGE, size, Ordering::Insertion).count();
+    }
+    CHECK(turnsAfter > 0);
+}
+
+TEST_CASE("Allocation tracker charges the current stage") {
+    AllocationTracker tracker;
+    std::vector<int> values(100);
+    CHECK(tracker[AllocationTracker::OUTSIDE_TURNS].allocations == 1);
+    CHECK(tracker[AllocationTracker::OUTSIDE_TURNS].bytes == 100 * sizeof(int));
+    {
+        AllocationTracker inner;
+        inner.stage = (int) Phase::Move;
+        values.resize(1000);
+        CHECK(inner[(int) Phase::Move].allocations == 1);
+        CHECK(tracker.total().allocations == 1);
+    }
+    CHECK(tracker.total().allocations == 2);
+    CHECK(tracker.total().deallocations == 1);
+    CHECK(tracker.report().find("move") != std::string::npos);
+
+    // A failed allocation calls the new handler until it removes itself.
+    static int calls = 0;
+    std::set_new_handler([] {
+        if (++calls == 2) {
+            std::set_new_handler(nullptr);
+        }
+    });
+    CHECK_THROWS_AS((void) ::operator new(SIZE_MAX / 2), std::bad_alloc);
+    CHECK(calls == 2);
+    CHECK(::operator new(SIZE_MAX / 2, std::nothrow) == nullptr);
+    void *empty = ::operator new(0, std::align_val_t(64));
+    CHECK(empty != nullptr);
+    ::operator delete(empty, std::align_val_t(64));
+}
+
+TEST_CASE("Matches allocate nothing once warmed up") {
+    std::mt19937 random(43);
+    std::vector<Scenario> scenarios;
+    for (int i = 0; i < 200; ++i) {
+        scenarios.push_back(randomScenario(random, MAX_MEMBERS, i % 2 == 0 ? 5 : 300));
+    }
+    Match::play(scenarios.front());
+    std::vector<Battle> battles;
+    for (const Scenario &scenario: scenarios) {
+        battles.emplace_back(scenario);
+    }
+    std::vector<Battle> replays = battles;
+    EventEngine engine(Schedule::Sparse);
+    for (Battle &battle: battles) {
+        engine.play(battle);
+    }
+
+    AllocationTracker tracker;
+    for (const Scenario &scenario: scenarios) {
+        Match::play(scenario);
+        Match::play(scenario, STEP_BY_STEP);
+        AllocationObserver observer(tracker);
+        Scenario played = scenario;
+        Match::stepByStep(played, observer);
+    }
+    for (Battle &battle: replays) {
+        engine.play(battle);
+    }
+    CHECK(tracker.total().allocations == 0);
+    CHECK(tracker.total().bytes == 0);
+}
+
+TEST_CASE("Tracer records every round and attack of a match") {
+    std::mt19937 random(44);
+    Scenario scenario = randomScenario(random, MAX_MEMBERS, 200);
+    Outcome expected = Match::play(scenario, STEP_BY_STEP);
+    Tracer full(TraceOptions{1 << 16, TraceMode::Full, 1});
+    Scenario played = scenario;
+    Outcome outcome = Match::stepByStep(played, full);
+    CHECK(outcome.rounds == expected.rounds);
+    CHECK(outcome.winner == expected.winner);
+    CHECK(full.dropped() == 0);
+    CHECK(full.count(SpanKind::Round) == (size_t) expected.rounds);
+    CHECK(full.count(SpanKind::Attack) == 2 * (size_t) expected.rounds);
+    CHECK(full.count(SpanKind::Victim) >= 2 * (size_t) expected.rounds - 1);
+    std::ostringstream json;
+    full.write(json);
+    std::string text = json.str();
+    CHECK(text.rfind("{\"displayTimeUnit\"", 0) == 0);
+    CHECK(text.find("\n]}") != std::string::npos);
+    size_t events = 0;
+    for (size_t at = text.find("\"ph\":\"X\""); at != std::string::npos; at = text.find("\"ph\":\"X\"", at + 1)) {
+        events++;
+    }
+    CHECK(events == full.size());
+    // Fixed point microseconds, never scientific notation.
+    for (size_t at = text.find("\"dur\":"); at != std::string::npos; at = text.find("\"dur\":", at + 1)) {
+        size_t end = text.find(',', at);
+        std::string value = text.substr(at + 6, end - at - 6);
+        REQUIRE(value.find('.') == value.size() - 4);
+        REQUIRE(value.find_first_not_of("0123456789.") == std::string::npos);
+    }
+}
+
+TEST_CASE("Tracer keeps memory bounded with a ring or sampling") {
+    std::mt19937 random(45);
+    Scenario scenario = randomScenario(random, MAX_MEMBERS, 400);
+    Tracer ring(TraceOptions{64, TraceMode::Ring, 1});
+    Scenario played = scenario;
+    Outcome outcome = Match::stepByStep(played, ring);
+    CHECK(ring.size() == 64);
+    CHECK(ring.dropped() > 0);
+    Tracer sampled(TraceOptions{1 << 16, TraceMode::Sampled, 10});
+    played = scenario;
+    Match::stepByStep(played, sampled);
+    CHECK(sampled.count(SpanKind::Round) == (size_t) (outcome.rounds + 9) / 10);
+    Tracer capped(TraceOptions{10, TraceMode::Full, 1});
+    played = scenario;
+    Match::stepByStep(played, capped);
+    CHECK(capped.size() == 10);
+    CHECK(capped.count(SpanKind::Victim) >= 1);
+    CHECK_THROWS_AS(Tracer(TraceOptions{0, TraceMode::Ring, 1}), std::invalid_argument);
+}
+
+TEST_CASE("Every engine agrees with the reference rules") {
+    Fuzzer fuzzer(46);
+    std::vector<Discrepancy> found = fuzzer.run(150);
+    for (const Discrepancy &discrepancy: found) {
+        MESSAGE(discrepancy.engine << " differs at attack " << discrepancy.attack);
+    }
+    CHECK(found.empty());
+}
+
+TEST_CASE("Fuzzer catches and shrinks a broken engine") {
+    // Cowboys that never reload: only shows once somebody empties a gun.
+    Engine broken{"no reloads", [](const Scenario &start, int maxRounds, std::vector<std::uint64_t> &hashes) {
+        Scenario scenario = start;
+        auto attack = [&](Roster &attackers, Roster &defenders) {
+            std::array<int, MAX_MEMBERS> bullets{};
+            for (int i = 0; i < attackers.size; ++i) {
+                bullets[(size_t) i] = attackers.members[(size_t) i].bullets;
+            }
+            Match::attack(attackers, defenders);
+            for (int i = 0; i < attackers.size; ++i) {
+                if (bullets[(size_t) i] == 0) {
+                    attackers.members[(size_t) i].bullets = 0;
+                }
+            }
+            hashes.push_back(Zobrist::hash(scenario));
+        };
+        int rounds = 0;
+        while (rounds < maxRounds && scenario.first.stillAlive() > 0 && scenario.second.stillAlive() > 0) {
+            attack(scenario.first, scenario.second);
+            attack(scenario.second, scenario.first);
+            rounds++;
+        }
+        return Match::result(scenario, rounds);
+    }, true};
+    Fuzzer fuzzer(47, {broken});
+    std::vector<Discrepancy> found = fuzzer.run(20);
+    REQUIRE(!found.empty());
+    int duels = 0;
+    for (const Discrepancy &discrepancy: found) {
+        CHECK(discrepancy.engine == "no reloads");
+        CHECK(discrepancy.attack >= 0);
+        CHECK(fuzzer.check(discrepancy.scenario, broken).has_value());
+        duels += discrepancy.scenario.first.size == 1 && discrepancy.scenario.second.size == 1 ? 1 : 0;
+    }
+    CHECK(duels > 0);
+    Scenario scenario = fuzzer.generate();
+    while (!fuzzer.check(scenario, broken)) {
+        scenario = fuzzer.generate();
+    }
+    Scenario smallest = fuzzer.minimize(scenario, broken);
+    CHECK(smallest.first.size <= scenario.first.size);
+    CHECK(smallest.second.size <= scenario.second.size);
+    CHECK(fuzzer.check(smallest, broken).has_value());
+    Scenario fine;
+    fine.first.add(Kind::YoungNinja, 0, 0);
+    fine.second.add(Kind::TrainedNinja, 0, 0.5);
+    CHECK(!fuzzer.check(fine, broken).has_value());
+}
+
+TEST_CASE("C interface plays batches in caller owned buffers") {
+    CHECK(cn_abi_version() == CN_ABI_VERSION);
+    std::mt19937 random(48);
+    std::vector<cn_scenario> scenarios(64);
+    std::vector<Scenario> expected;
+    for (cn_scenario &scenario: scenarios) {
+        REQUIRE(cn_team_init(&scenario.first, CN_COWBOYS_FIRST) == CN_OK);
+        REQUIRE(cn_team_init(&scenario.second, CN_INSERTION) == CN_OK);
+        Scenario mirror{Roster(Ordering::CowboysFirst), Roster(Ordering::Insertion)};
+        for (int i = 0; i < 6; ++i) {
+            int kind = (int) (random() % 4);
+            double x = random() % 100;
+            double y = random() % 100;
+            CHECK(cn_team_add(i % 2 == 0 ? &scenario.first : &scenario.second, kind, x, y) == CN_OK);
+            (i % 2 == 0 ? mirror.first : mirror.second).add(static_cast<Kind>(kind), x, y);
+        }
+        expected.push_back(mirror);
+    }
+    cn_options options;
+    cn_default_options(&options);
+    std::vector<cn_outcome> outcomes(scenarios.size());
+    REQUIRE(cn_play_batch(scenarios.data(), outcomes.data(), scenarios.size(), 2, &options) == CN_OK);
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        Outcome outcome = Match::play(expected[i]);
+        CHECK(outcomes[i].winner == (int) outcome.winner);
+        CHECK(outcomes[i].rounds == outcome.rounds);
+        CHECK(outcomes[i].alive_first == outcome.aliveFirst);
+        CHECK(outcomes[i].health_second == outcome.healthSecond);
+    }
+    cn_outcome single;
+    REQUIRE(cn_play(&scenarios[0], &single, nullptr) == CN_OK);
+    CHECK(single.rounds == outcomes[0].rounds);
+}
+
+TEST_CASE("C interface reports bad input with status codes") {
+    cn_team team;
+    CHECK(cn_team_init(&team, 7) == CN_INVALID_ARGUMENT);
+    REQUIRE(cn_team_init(&team, CN_COWBOYS_FIRST) == CN_OK);
+    CHECK(cn_team_add(&team, 9, 0, 0) == CN_INVALID_ARGUMENT);
+    for (int i = 0; i < CN_MAX_MEMBERS; ++i) {
+        CHECK(cn_team_add(&team, CN_OLD_NINJA, i, 0) == CN_OK);
+    }
+    CHECK(cn_team_add(&team, CN_COWBOY, 0, 0) == CN_TEAM_FULL);
+    cn_scenario scenario{team, team};
+    scenario.second.size = 0;
+    cn_outcome outcome{};
+    CHECK(cn_play(&scenario, &outcome, nullptr) == CN_INVALID_ARGUMENT);
+    CHECK(cn_play_batch(nullptr, nullptr, 0, 0, nullptr) == CN_OK);
+    CHECK(cn_play_batch(&scenario, nullptr, 1, 0, nullptr) == CN_INVALID_ARGUMENT);
+
+    cn_scenario duel;
+    REQUIRE(cn_team_init(&duel.first, CN_COWBOYS_FIRST) == CN_OK);
+    REQUIRE(cn_team_init(&duel.second, CN_INSERTION) == CN_OK);
+    REQUIRE(cn_team_add(&duel.first, CN_COWBOY, 0, 0) == CN_OK);
+    REQUIRE(cn_team_add(&duel.second, CN_YOUNG_NINJA, 3, 4) == CN_OK);
+    CHECK(cn_team_add(&duel.second, CN_OLD_NINJA, std::nan(""), 0) == CN_INVALID_ARGUMENT);
+    CHECK(cn_team_add(&duel.second, CN_OLD_NINJA, 0, INFINITY) == CN_INVALID_ARGUMENT);
+    REQUIRE(cn_play(&duel, &outcome, nullptr) == CN_OK);
+    auto rejects = [&](auto &&corrupt) {
+        cn_scenario broken = duel;
+        corrupt(broken.first.members[0]);
+        return cn_play(&broken, &outcome, nullptr) == CN_INVALID_ARGUMENT;
+    };
+    CHECK(rejects([](cn_fighter &fighter) { fighter.bullets = -1; }));
+    CHECK(rejects([](cn_fighter &fighter) { fighter.bullets = COWBOY_BULLETS + 1; }));
+    CHECK(rejects([](cn_fighter &fighter) { fighter.health = 0; }));
+    CHECK(rejects([](cn_fighter &fighter) { fighter.health = -10; }));
+    CHECK(rejects([](cn_fighter &fighter) { fighter.health = COWBOY_HEALTH + 1; }));
+    CHECK(rejects([](cn_fighter &fighter) { fighter.x = std::nan(""); }));
+    CHECK(rejects([](cn_fighter &fighter) { fighter.y = -INFINITY; }));
+    CHECK_FALSE(rejects([](cn_fighter &fighter) { fighter.health = 1; }));
+}
+
+TEST_CASE("Scenario files read back what was written") {
+    std::mt19937 random(49);
+    std::vector<Scenario> scenarios;
+    for (int i = 0; i < 50; ++i) {
+        Scenario scenario = randomScenario(random, 1 + i % MAX_MEMBERS, 100);
+        scenario.first.leader = 0;
+        scenario.second.leader = 0;
+        scenarios.push_back(scenario);
+    }
+    auto same = [](const Roster &one, const Roster &other) {
+        bool equal = one.size == other.size && one.leader == other.leader && one.ordering == other.ordering;
+        for (int i = 0; equal && i < one.size; ++i) {
+            const Fighter &a = one.members[(size_t) i];
+            const Fighter &b = other.members[(size_t) i];
+            equal = a.kind == b.kind && a.x == b.x && a.y == b.y && a.health == b.health;
+        }
+        return equal;
+    };
+    for (bool binary: {false, true}) {
+        std::string path = binary ? "/tmp/scenarios-test.bin" : "/tmp/scenarios-test.txt";
+        {
+            std::ofstream out(path, std::ios::binary);
+            if (binary) {
+                ScenarioFile::writeBinary(out, scenarios);
+            } else {
+                out << "# written by the tests\n\n";
+                ScenarioFile::writeText(out, scenarios);
+            }
+        }
+        ScenarioFile file(path);
+        CHECK(file.binary() == binary);
+        REQUIRE(file.scenarios().size() == scenarios.size());
+        for (size_t i = 0; i < scenarios.size(); ++i) {
+            CHECK(same(file.scenarios()[i].first, scenarios[i].first));
+            CHECK(same(file.scenarios()[i].second, scenarios[i].second));
+        }
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("Scenario text is checked while parsed") {
+    std::vector<Scenario> parsed;
+    ScenarioFile::parseText("C c 0 0 y 3.5 4 | I o 20 3 t 21 3\r\n  # nothing\nI t -1 2|C c 5 5", parsed);
+    REQUIRE(parsed.size() == 2);
+    CHECK(parsed[0].first.size == 2);
+    CHECK(parsed[0].second.ordering == Ordering::Insertion);
+    CHECK(parsed[0].second.members[1].kind == Kind::TrainedNinja);
+    CHECK(parsed[1].first.members[0].x == -1);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C c 0 0", parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C c 0 | C c 0 0", parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C x 0 0 | C c 0 0", parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C c 0 0 | I", parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C c 0 0 c 1 1 c 2 2 c 3 3 c 4 4 c 5 5 c 6 6 c 7 7 c 8 8 c 9 9 c 1 0 | I c 0 0",
+                                            parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C c 0 0 | I c 1 1 | C c 2 2", parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C c 0 0 | I c 1 1 x", parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C c nan 0 | I c 1 1", parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::parseText("C c 0 inf | I c 1 1", parsed), std::runtime_error);
+    CHECK_THROWS_AS(ScenarioFile::viewBinary("CNSCENE1\x02"), std::runtime_error);
+
+    // Binary files are checked field by field, as the C interface is.
+    Scenario duel;
+    duel.first.add(Kind::Cowboy, 0, 0);
+    duel.second.add(Kind::OldNinja, 3, 4);
+    auto view = [](const Scenario &scenario) {
+        std::ostringstream out;
+        ScenarioFile::writeBinary(out, {&scenario, 1});
+        std::string bytes = out.str();
+        std::vector<std::uint64_t> aligned(bytes.size() / sizeof(std::uint64_t) + 1);
+        std::memcpy(aligned.data(), bytes.data(), bytes.size());
+        return ScenarioFile::viewBinary({reinterpret_cast<const char *>(aligned.data()), bytes.size()}).size();
+    };
+    CHECK(view(duel) == 1);
+    for (int field = 0; field < 5; ++field) {
+        Scenario broken = duel;
+        Fighter &fighter = broken.first.members[0];
+        switch (field) {
+            case 0: fighter.bullets = -1; break;
+            case 1: fighter.bullets = COWBOY_BULLETS + 1; break;
+            case 2: fighter.health = 0; break;
+            case 3: fighter.health = COWBOY_HEALTH + 1; break;
+            default: fighter.x = std::nan(""); break;
+        }
+        CHECK_THROWS_AS(view(broken), std::runtime_error);
+    }
+    CHECK_THROWS_AS(ScenarioFile("/nonexistent/scenarios"), std::runtime_error);
+}
+
+TEST_CASE("Result rows count survivors the same with or without shortcuts") {
+    std::mt19937 random(50);
+    for (int i = 0; i < 200; ++i) {
+        Scenario start = randomScenario(random, 1 + i % MAX_MEMBERS, 60);
+        Scenario fast = start;
+        Scenario slow = start;
+        ResultRow quick = ResultRow::of(1, start, fast, Match::playInPlace(fast));
+        ResultRow exact = ResultRow::of(1, start, slow, Match::playInPlace(slow, STEP_BY_STEP));
+        CHECK(quick.winner == exact.winner);
+        CHECK(quick.rounds == exact.rounds);
+        CHECK(quick.first == exact.first);
+        CHECK(quick.second == exact.second);
+        CHECK(quick.damageFirst == exact.damageFirst);
+        CHECK(quick.damageSecond == exact.damageSecond);
+        int survivors = 0;
+        for (int kind = 0; kind < 4; ++kind) {
+            survivors += exact.first[(size_t) kind];
+        }
+        CHECK(survivors == slow.first.stillAlive());
+    }
+}
+
+TEST_CASE("Result columns are written in blocks and scanned one at a time") {
+    std::mt19937 random(51);
+    std::vector<ResultRow> rows;
+    std::string path = "/tmp/results-test.cnr";
+    {
+        ResultWriter writer(path, 7);
+        for (int i = 0; i < 40; ++i) {
+            Scenario start = randomScenario(random, MAX_MEMBERS, 100);
+            Scenario end = start;
+            Outcome outcome = Match::playInPlace(end);
+            rows.push_back(ResultRow::of((std::uint64_t) i * 3, start, end, outcome));
+            writer.append(rows.back());
+            if (i == 17) {
+                writer.flush();
+            }
+        }
+        CHECK(writer.rows() == 40);
+    }
+    ResultReader reader(path);
+    CHECK(reader.rows() == 40);
+    CHECK(reader.blocks() == 7);
+    std::int64_t rounds = 0;
+    std::int64_t expected = 0;
+    size_t seen = 0;
+    for (size_t block = 0; block < reader.blocks(); ++block) {
+        for (std::int32_t value: reader.column<std::int32_t>(block, Column::Rounds)) {
+            rounds += value;
+        }
+        for (size_t i = 0; i < reader.rowsIn(block); ++i, ++seen) {
+            ResultRow row = reader.row(block, i);
+            CHECK(row.scenario == rows[seen].scenario);
+            CHECK(row.winner == rows[seen].winner);
+            CHECK(row.first == rows[seen].first);
+            CHECK(row.second == rows[seen].second);
+            CHECK(row.damageSecond == rows[seen].damageSecond);
+        }
+    }
+    for (const ResultRow &row: rows) {
+        expected += row.rounds;
+    }
+    CHECK(seen == rows.size());
+    CHECK(rounds == expected);
+    CHECK_THROWS_AS(reader.column<std::int64_t>(0, Column::Rounds), std::invalid_argument);
+    std::remove(path.c_str());
+    CHECK_THROWS_AS(ResultWriter(path, 0), std::invalid_argument);
+}
+
+TEST_CASE("Compile time square roots match std::sqrt") {
+    constexpr int SAMPLES = 600;
+    constexpr auto samples = [] {
+        std::array<double, SAMPLES> values{};
+        std::uint64_t state = 52;
+        for (double &value: values) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            int exponent = (int) (state >> 58) - 32;
+            double mantissa = 1 + (double) (state >> 12) / 0x1p52;
+            value = mantissa;
+            for (int i = 0; i < (exponent < 0 ? -exponent : exponent); ++i) {
+                value = exponent < 0 ? value / 7 : value * 7;
+            }
+        }
+        return values;
+    }();
+    constexpr auto roots = [&] {
+        std::array<double, SAMPLES> values{};
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = squareRoot(samples[i]);
+        }
+        return values;
+    }();
+    for (size_t i = 0; i < samples.size(); ++i) {
+        CHECK(roots[i] == std::sqrt(samples[i]));
+    }
+}
+
+TEST_CASE("Duels checked at compile time agree with the rules at run time") {
+    for (Kind first: {Kind::Cowboy, Kind::YoungNinja, Kind::TrainedNinja, Kind::OldNinja}) {
+        for (Kind second: {Kind::Cowboy, Kind::YoungNinja, Kind::TrainedNinja, Kind::OldNinja}) {
+            Scenario scenario;
+            scenario.first.add(first, 0, 0);
+            scenario.second.add(second, 21.25, 21.25);
+            Outcome outcome = Match::play(scenario);
+            CHECK(outcome.rounds == duel(first, second, 21.25).rounds);
+            CHECK(outcome.winner == duel(first, second, 21.25).winner);
+        }
+    }
+}
+
+TEST_CASE("Turns yields the state after every half-turn") {
+    std::mt19937 random(53);
+    for (int i = 0; i < 30; ++i) {
+        Scenario scenario = randomScenario(random, 1 + i % MAX_MEMBERS, 80);
+        Scenario stepped = scenario;
+        int halfTurns = 0;
+        for (const TurnView &view: turns(scenario)) {
+            Roster &attackers = halfTurns % 2 == 0 ? stepped.first : stepped.second;
+            Roster &defenders = halfTurns % 2 == 0 ? stepped.second : stepped.first;
+            Match::attack(attackers, defenders);
+            CHECK(view.halfTurns == ++halfTurns);
+            CHECK(view.attacker == (halfTurns - 1) % 2);
+            CHECK(view.round == (halfTurns - 1) / 2);
+            CHECK(Zobrist::hash(*view.scenario) == Zobrist::hash(stepped));
+        }
+        Turns match = turns(scenario);
+        while (match.next()) {
+        }
+        Outcome expected = Match::play(scenario, STEP_BY_STEP);
+        CHECK(match.outcome().winner == expected.winner);
+        CHECK(match.outcome().rounds == expected.rounds);
+        CHECK(match.outcome().healthFirst == expected.healthFirst);
+        CHECK(match.outcome().healthSecond == expected.healthSecond);
+    }
+}
+
+TEST_CASE("Turns strides over unwatched rounds without allocating") {
+    std::mt19937 random(54);
+    Scenario warm = randomScenario(random, MAX_MEMBERS, 100);
+    {
+        Turns first = turns(warm);
+        first.next();
+    }
+    for (int stride: {1, 3, 10, 64}) {
+        Scenario scenario = randomScenario(random, MAX_MEMBERS, 300);
+        Scenario stepped = scenario;
+        int played = 0;
+        std::vector<int> seen;
+        seen.reserve(1024);
+        AllocationTracker tracker;
+        Turns match = turns(scenario);
+        while (match.advance(stride)) {
+            const TurnView &view = match.view();
+            while (played < view.halfTurns) {
+                Match::attack(played % 2 == 0 ? stepped.first : stepped.second,
+                              played % 2 == 0 ? stepped.second : stepped.first);
+                played++;
+            }
+            CHECK(Zobrist::hash(*view.scenario) == Zobrist::hash(stepped));
+            seen.push_back(view.halfTurns);
+        }
+        CHECK(tracker.total().allocations == 0);
+        for (size_t i = 0; i + 1 < seen.size(); ++i) {
+            CHECK(seen[i] == stride * (int) (i + 1));
+        }
+        Outcome expected = Match::play(scenario, STEP_BY_STEP);
+        CHECK(match.outcome().rounds == expected.rounds);
+        CHECK(match.outcome().winner == expected.winner);
+    }
+    CHECK(Turns::pooledFrames() >= 1);
+}
+
+TEST_CASE("Snapshot readers only see whole attacks") {
+    std::mt19937 random(55);
+    Scenario scenario = randomScenario(random, MAX_MEMBERS, 2000);
+    std::vector<std::uint64_t> hashes;
+    {
+        Scenario stepped = scenario;
+        int rounds = 0;
+        while (stepped.first.stillAlive() > 0 && stepped.second.stillAlive() > 0) {
+            Match::attack(stepped.first, stepped.second);
+            hashes.push_back(Zobrist::hash(stepped));
+            if (stepped.second.stillAlive() > 0) {
+                Match::attack(stepped.second, stepped.first);
+                hashes.push_back(Zobrist::hash(stepped));
+            }
+            rounds++;
+        }
+    }
+    SnapshotPublisher publisher;
+    Snapshot snapshot;
+    CHECK(!publisher.read(snapshot));
+    std::atomic<bool> running{true};
+    std::vector<std::vector<std::pair<int, std::uint64_t>>> seen(3);
+    std::vector<std::thread> readers;
+    for (auto &samples: seen) {
+        readers.emplace_back([&publisher, &running, &samples] {
+            Snapshot copy;
+            std::uint64_t last = 0;
+            while (running.load()) {
+                if (publisher.read(copy) && copy.version != last && copy.halfTurns > 0) {
+                    last = copy.version;
+                    samples.emplace_back(copy.halfTurns, Zobrist::hash(copy.scenario));
+                }
+            }
+        });
+    }
+    for (const TurnView &view: turns(scenario)) {
+        publisher.publish(view);
+        std::this_thread::yield();
+    }
+    running = false;
+    for (auto &reader: readers) {
+        reader.join();
+    }
+    REQUIRE(publisher.read(snapshot));
+    CHECK(snapshot.halfTurns == (int) hashes.size());
+    Outcome outcome = publisher.play(scenario);
+    CHECK(outcome.rounds == Match::play(scenario, STEP_BY_STEP).rounds);
+    REQUIRE(publisher.read(snapshot));
+    CHECK(snapshot.finished);
+    CHECK(snapshot.halfTurns == (int) hashes.size());
+    CHECK(!(seen[0].empty() && seen[1].empty() && seen[2].empty()));
+    for (const auto &samples: seen) {
+        int previous = 0;
+        for (const auto &[halfTurns, hash]: samples) {
+            REQUIRE(halfTurns <= (int) hashes.size());
+            CHECK(hash == hashes[(size_t) halfTurns - 1]);
+            CHECK(halfTurns >= previous);
+            previous = halfTurns;
+        }
+    }
+}
+
+TEST_CASE("Command queue keeps each producer's order and its bound") {
+    CommandQueue queue;
+    Command command;
+    CHECK(queue.empty());
+    CHECK(!queue.pop(command));
+    constexpr int PER_PRODUCER = 2000;
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < 3; ++producer) {
+        producers.emplace_back([&queue, producer] {
+            for (int i = 0; i < PER_PRODUCER; ++i) {
+                while (!queue.push(Command{Order::Leader, producer, i})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::array<int, 3> next{};
+    int received = 0;
+    while (received < 3 * PER_PRODUCER) {
+        if (!queue.pop(command)) {
+            std::this_thread::yield();
+            continue;
+        }
+        CHECK(command.member == next[(size_t) command.team]++);
+        received++;
+    }
+    for (auto &producer: producers) {
+        producer.join();
+    }
+    CHECK(queue.empty());
+    for (std::uint64_t i = 0; i < CommandQueue::CAPACITY; ++i) {
+        CHECK(queue.push(Command{}));
+    }
+    CHECK(!queue.push(Command{}));
+}
+
+TEST_CASE("Commander applies valid commands at turn boundaries") {
+    Scenario scenario{Roster(Ordering::CowboysFirst), Roster(Ordering::Insertion)};
+    scenario.first.add(Kind::Cowboy, 0, 0);
+    scenario.second.add(Kind::OldNinja, 5, 0);
+    scenario.second.add(Kind::YoungNinja, 50, 0);
+    Commander commander;
+    CHECK(commander.submit(Command{Order::Victim, 0, 1}));
+    commander.attack(scenario, 0);
+    CHECK(scenario.second.members[0].health == 150);
+    CHECK(scenario.second.members[1].health == 90);
+    commander.attack(scenario, 0);
+    CHECK(scenario.second.members[0].health == 140);
+
+    commander.submit(Command{Order::Leader, 1, 1});
+    commander.submit(Command{Order::Leader, 1, 7});
+    commander.submit(Command{Order::Victim, 1, 3});
+    commander.submit(Command{Order::Reinforce, 0, 0, Kind::TrainedNinja, 1, 1});
+    commander.submit(Command{Order::Reinforce, 0, 0, Kind::Cowboy, 2, 2});
+    commander.submit(Command{Order::Leader, 2, 0});
+    commander.drain(scenario);
+    CHECK(commander.appliedCount() == 4);
+    CHECK(commander.rejectedCount() == 3);
+    CHECK(scenario.second.leader == 1);
+    CHECK(scenario.first.size == 3);
+    CHECK(scenario.first.members[1].isCowboy());
+    CHECK(scenario.first.members[2].kind == Kind::TrainedNinja);
+    for (int i = 3; i < MAX_MEMBERS; ++i) {
+        commander.submit(Command{Order::Reinforce, 0, 0, Kind::OldNinja, 0, (double) i});
+    }
+    commander.submit(Command{Order::Reinforce, 0, 0, Kind::OldNinja, 0, 0});
+    commander.drain(scenario);
+    CHECK(scenario.first.size == MAX_MEMBERS);
+    CHECK(commander.rejectedCount() == 4);
+
+    std::mt19937 random(56);
+    Scenario quiet = randomScenario(random, MAX_MEMBERS, 100);
+    Scenario played = quiet;
+    Outcome outcome = Commander().play(played);
+    Outcome expected = Match::play(quiet, STEP_BY_STEP);
+    CHECK(outcome.rounds == expected.rounds);
+    CHECK(outcome.healthFirst == expected.healthFirst);
+    CHECK(outcome.healthSecond == expected.healthSecond);
+}
+
+TEST_CASE("Tick server plays hosted matches by the rules on schedule") {
+    std::mt19937 random(48);
+    TickServer server(std::chrono::microseconds(50));
+    std::vector<Scenario> scenarios;
+    for (int i = 0; i < 6; ++i) {
+        scenarios.push_back(randomScenario(random, 1 + i, 30));
+        TickOptions options;
+        options.period = std::chrono::microseconds(100 + 50 * i);
+        options.budget = std::chrono::seconds(1);
+        CHECK(server.host(scenarios.back(), options) == i);
+    }
+    CHECK_THROWS_AS(server.host(scenarios[0], TickOptions{std::chrono::nanoseconds(0)}), std::invalid_argument);
+    CHECK(server.running() == 6);
+    server.runFor(std::chrono::seconds(30));
+    CHECK(server.running() == 0);
+    for (int i = 0; i < 6; ++i) {
+        const LiveMatch &match = server.match(i);
+        Outcome expected = Match::play(scenarios[(size_t) i], STEP_BY_STEP);
+        CHECK(match.finished);
+        CHECK(match.overruns == 0);
+        CHECK(match.degradedTicks == 0);
+        CHECK(match.outcome.rounds == expected.rounds);
+        CHECK(match.outcome.healthFirst == expected.healthFirst);
+        CHECK(match.outcome.healthSecond == expected.healthSecond);
+    }
+}
+
+TEST_CASE("Tick server degrades overrunning matches to sticky victims") {
+    Scenario scenario{Roster(Ordering::CowboysFirst), Roster(Ordering::Insertion)};
+    scenario.first.add(Kind::Cowboy, 0, 0);
+    scenario.second.add(Kind::OldNinja, 5, 0);
+    scenario.second.add(Kind::YoungNinja, 50, 0);
+    LiveMatch sticky;
+    sticky.scenario = scenario;
+    sticky.policy = Policy::Sticky;
+    sticky.lastVictims = {1, -1};
+    TickServer::playRound(sticky);
+    CHECK(sticky.scenario.second.members[1].health == 90);
+    CHECK(sticky.scenario.second.members[0].health == 150);
+    CHECK(sticky.lastVictims[0] == 1);
+
+    std::mt19937 random(480);
+    TickServer server(std::chrono::microseconds(50));
+    TickOptions options;
+    options.period = std::chrono::microseconds(100);
+    options.budget = std::chrono::nanoseconds(1);
+    for (int i = 0; i < 4; ++i) {
+        server.host(randomScenario(random, MAX_MEMBERS, 30), options);
+    }
+    server.runFor(std::chrono::seconds(30));
+    CHECK(server.running() == 0);
+    for (int i = 0; i < 4; ++i) {
+        const LiveMatch &match = server.match(i);
+        CHECK(match.finished);
+        CHECK(match.overruns == (std::uint64_t) match.rounds);
+        CHECK(match.degradedTicks == (std::uint64_t) match.rounds - 1);
+        CHECK(match.policy == Policy::Sticky);
+        CHECK(match.worst.count() > 0);
+    }
+}
+
+TEST_CASE("Teams keep up to ten members inline") {
+    InlineVector<int, 3> small;
+    small.push_back(4);
+    small.push_back(0);
+    small.push_back(7);
+    CHECK(small.full());
+    CHECK_THROWS_AS(small.push_back(1), std::runtime_error);
+    CHECK(small.mask([](int value) { return value > 0; }) == 0b101);
+    int sum = 0;
+    for (int value: small) {
+        sum += value;
+    }
+    CHECK(sum == 11);
+
+    Team team(new Cowboy("Tom", Point(0, 0)));
+    for (int i = 1; i < MAX_MEMBERS; ++i) {
+        team.add(new OldNinja("Ninja", Point(i, 0)));
+    }
+    CHECK(team.team.size() == MAX_MEMBERS);
+    auto *extra = new YoungNinja("Extra", Point(0, 1));
+    CHECK_THROWS_AS(team.add(extra), std::runtime_error);
+    delete extra;
+    CHECK(team.team.size() == MAX_MEMBERS);
+    static_assert(sizeof(Team) > MAX_MEMBERS * sizeof(Character *));
+
+    // A missing member never counts as living.
+    Team leaderless(nullptr);
+    CHECK(leaderless.living() == 0);
+    for (int i = 1; i < MAX_MEMBERS; ++i) {
+        leaderless.add(new Cowboy("Tom", Point(i, 0)));
+    }
+    auto *late = new Cowboy("Late", Point(0, 1));
+    CHECK_THROWS_WITH_AS(leaderless.add(late), "a team can not have more than ten members", std::runtime_error);
+    delete late;
+}
@@ -0,0 +1,142 @@
+//
+// Created by avida on 5/24/2023.
+//
+
+#include "Allocations.hpp"
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+namespace ariel {
+
+    static thread_local AllocationTracker *tracking = nullptr;
+
+    AllocationCounts &AllocationCounts::operator+=(const AllocationCounts &other) {
+        allocations += other.allocations;
+        deallocations += other.deallocations;
+        bytes += other.bytes;
+        return *this;
+    }
+
+    AllocationTracker::AllocationTracker() : outer(tracking) {
+        tracking = this;
+    }
+
+    AllocationTracker::~AllocationTracker() {
+        tracking = outer;
+        if (outer != nullptr) {
+            outer->counts[(size_t) outer->stage] += total();
+        }
+    }
+
+    AllocationTracker *AllocationTracker::active() {
+        return tracking;
+    }
+
+    void AllocationTracker::allocated(std::size_t bytes) {
+        AllocationCounts &slot = counts[(size_t) stage];
+        slot.allocations++;
+        slot.bytes += bytes;
+    }
+
+    AllocationCounts AllocationTracker::total() const {
+        AllocationCounts sum;
+        for (const AllocationCounts &slot: counts) {
+            sum += slot;
+        }
+        return sum;
+    }
+
+    std::string AllocationTracker::report() const {
+        std::ostringstream out;
+        out << "stage allocations deallocations bytes\n";
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            const char *name = slot == TURN_STAGE ? "turn" : slot == OUTSIDE_TURNS ? "outside" : phaseName((Phase) slot);
+            out << name << ' ' << counts[(size_t) slot].allocations << ' ' << counts[(size_t) slot].deallocations
+                << ' ' << counts[(size_t) slot].bytes << '\n';
+        }
+        return out.str();
+    }
+
+} // ariel
+
+// Replacements of the global allocation functions. They only differ from the
+// library ones by telling the thread's tracker, if there is one. Like the
+// library ones, a failed allocation calls the new handler and tries again
+// until there is none left to call.
+
+static void *allocate(std::size_t size) {
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void *allocateAligned(std::size_t size, std::align_val_t alignment) {
+    auto align = (std::size_t) alignment;
+    // aligned_alloc wants a non zero multiple of the alignment.
+    return std::aligned_alloc(align, size == 0 ? align : (size + align - 1) / align * align);
+}
+
+template <class Allocate>
+static void *allocateOrThrow(std::size_t size, Allocate allocate) {
+    while (true) {
+        if (void *pointer = allocate()) {
+            if (ariel::AllocationTracker *tracker = ariel::tracking) {
+                tracker->allocated(size);
+            }
+            return pointer;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void release(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    if (ariel::AllocationTracker *tracker = ariel::tracking) {
+        tracker->released();
+    }
+    std::free(pointer);
+}
+
+void *operator new(std::size_t size) {
+    return allocateOrThrow(size, [size] { return allocate(size); });
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t & /*tag*/) noexcept {
+    try {
+        return operator new(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+    return operator new(size, tag);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, [size, alignment] { return allocateAligned(size, alignment); });
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept { release(pointer); }
+void operator delete[](void *pointer) noexcept { release(pointer); }
+void operator delete(void *pointer, std::size_t /*size*/) noexcept { release(pointer); }
+void operator delete[](void *pointer, std::size_t /*size*/) noexcept { release(pointer); }
+void operator delete(void *pointer, const std::nothrow_t & /*tag*/) noexcept { release(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t & /*tag*/) noexcept { release(pointer); }
+void operator delete(void *pointer, std::align_val_t /*alignment*/) noexcept { release(pointer); }
+void operator delete[](void *pointer, std::align_val_t /*alignment*/) noexcept { release(pointer); }
+void operator delete(void *pointer, std::size_t /*size*/, std::align_val_t /*alignment*/) noexcept { release(pointer); }
+void operator delete[](void *pointer, std::size_t /*size*/, std::align_val_t /*alignment*/) noexcept { release(pointer); }
@@ -0,0 +1,74 @@
+//
+// Created by avida on 5/24/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_ALLOCATIONS_H
+#define COWBOY_VS_NINJA_A_ALLOCATIONS_H
+
+#include "Latency.hpp"
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace ariel {
+
+    struct AllocationCounts {
+        std::uint64_t allocations = 0;
+        std::uint64_t deallocations = 0;
+        std::uint64_t bytes = 0;
+
+        AllocationCounts &operator+=(const AllocationCounts &other);
+    };
+
+    // Counts the global new and delete calls of the constructing thread for
+    // as long as it lives, charging them to the current stage: one of the
+    // attack phases, TURN_STAGE for the rest of an attack or OUTSIDE_TURNS.
+    // Trackers nest; an inner one hands its totals to the stage of the outer
+    // one when it ends. The replaced operators cost one thread local check
+    // when nothing is tracking.
+    class AllocationTracker {
+    public:
+        static constexpr int OUTSIDE_TURNS = STAGES;
+        static constexpr int SLOTS = STAGES + 1;
+
+    private:
+        std::array<AllocationCounts, SLOTS> counts{};
+        AllocationTracker *outer;
+
+    public:
+        int stage = OUTSIDE_TURNS;
+
+        AllocationTracker();
+        AllocationTracker(const AllocationTracker &) = delete;
+        AllocationTracker &operator=(const AllocationTracker &) = delete;
+        ~AllocationTracker();
+
+        static AllocationTracker *active();
+        void allocated(std::size_t bytes);
+        void released() { counts[(size_t) stage].deallocations++; }
+
+        const AllocationCounts &operator[](int slot) const { return counts[(size_t) slot]; }
+        AllocationCounts total() const;
+        std::string report() const;
+    };
+
+    // Match::stepByStep observer that points the thread's tracker at the
+    // phase being played, and at TURN_STAGE for the rest of each attack.
+    class AllocationObserver : public NoObserver {
+        AllocationTracker *tracker;
+        int previous = AllocationTracker::OUTSIDE_TURNS;
+
+    public:
+        explicit AllocationObserver(AllocationTracker &tracker) : tracker(&tracker) {}
+
+        void enter(Phase phase) { tracker->stage = (int) phase; }
+        void leave(Phase /*phase*/) { tracker->stage = TURN_STAGE; }
+        void attackStarting(const Scenario & /*scenario*/, int /*side*/) {
+            previous = std::exchange(tracker->stage, TURN_STAGE);
+        }
+        void attackFinished(const Scenario & /*scenario*/, int /*side*/) { tracker->stage = previous; }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_ALLOCATIONS_H
@@ -0,0 +1,74 @@
+//
+// Created by avida on 5/22/2023.
+//
+
+#include "Arena.hpp"
+#include <algorithm>
+
+namespace ariel {
+
+    Arena::Arena(std::vector<Army> teams, double cellSize)
+            : armies(std::move(teams)), alive(armies.size()),
+              index(armies, cellSize > 0 ? cellSize : SpatialIndex::defaultCellSize(armies)) {
+        for (size_t team = 0; team < armies.size(); ++team) {
+            alive[team] = armies[team].stillAlive();
+            teamsAlive += alive[team] > 0 ? 1 : 0;
+        }
+    }
+
+    void Arena::attack(int team) {
+        Army &attackers = armies.at((size_t) team);
+        if (alive[(size_t) team] == 0 || teamsAlive < 2) {
+            return;
+        }
+        const Fighter &former = attackers.members[(size_t) attackers.leader];
+        if (!former.isAlive()) {
+            attackers.leader = index.closestMember(armies, team, former.x, former.y).member;
+        }
+        const Fighter &leader = attackers.members[(size_t) attackers.leader];
+        SpatialIndex::Entry victim = index.closestHostile(armies, team, leader.x, leader.y);
+        for (int i = 0; i < attackers.size; ++i) {
+            Fighter &attacker = attackers.members[(size_t) i];
+            if (!attacker.isAlive()) {
+                continue;
+            }
+            if (!armies[(size_t) victim.team].members[(size_t) victim.member].isAlive()) {
+                victim = index.closestHostile(armies, team, leader.x, leader.y);
+                if (victim.team < 0) {
+                    return;
+                }
+            }
+            Fighter &target = armies[(size_t) victim.team].members[(size_t) victim.member];
+            Match::act(attacker, target);
+            if (!attacker.isCowboy()) {
+                index.move(attacker, SpatialIndex::Entry{team, i});
+            }
+            if (!target.isAlive()) {
+                index.remove(victim);
+                if (--alive[(size_t) victim.team] == 0) {
+                    teamsAlive--;
+                }
+            }
+        }
+    }
+
+    void Arena::round() {
+        for (int team = 0; team < teams(); ++team) {
+            attack(team);
+        }
+    }
+
+    ArenaOutcome Arena::play(int maxRounds) {
+        int rounds = 0;
+        while (rounds < maxRounds && teamsAlive > 1) {
+            round();
+            rounds++;
+        }
+        int winner = -1;
+        if (teamsAlive == 1) {
+            winner = (int) (std::find_if(alive.begin(), alive.end(), [](int count) { return count > 0; }) - alive.begin());
+        }
+        return ArenaOutcome{winner, rounds, alive};
+    }
+
+} // ariel
@@ -0,0 +1,47 @@
+//
+// Created by avida on 5/22/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_ARENA_H
+#define COWBOY_VS_NINJA_A_ARENA_H
+
+#include "SpatialIndex.hpp"
+#include <vector>
+
+namespace ariel {
+
+    struct ArenaOutcome {
+        int winner;
+        int rounds;
+        std::vector<int> alive;
+    };
+
+    // Free for all among any number of teams. In every round each team attacks
+    // in index order: it re-elects its leader as in Match::attack and its
+    // members hit the living fighter of any other team that is closest to the
+    // leader, ties going to the lower team and then the lower member index.
+    // With two teams this is exactly Match::play.
+    class Arena {
+        std::vector<Army> armies;
+        std::vector<int> alive;
+        SpatialIndex index;
+        int teamsAlive = 0;
+
+    public:
+        // A cell size of 0 picks one that holds a couple of fighters per cell.
+        explicit Arena(std::vector<Army> teams, double cellSize = 0);
+
+        void attack(int team);
+        void round();
+        ArenaOutcome play(int maxRounds = MAX_ROUNDS);
+
+        int teams() const { return (int) armies.size(); }
+        const Army &team(int team) const { return armies.at((size_t) team); }
+        int stillAlive(int team) const { return alive.at((size_t) team); }
+        int standing() const { return teamsAlive; }
+        const SpatialIndex &spatialIndex() const { return index; }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_ARENA_H
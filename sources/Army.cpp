@@ -0,0 +1,82 @@
+//
+// Created by avida on 5/21/2023.
+//
+
+#include "Army.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace ariel {
+
+    Army::Army(const Roster &roster)
+            : members(roster.members.begin(), roster.members.begin() + roster.size), size(roster.size),
+              leader(roster.leader), ordering(roster.ordering) {
+    }
+
+    // Builds an army from fighters in insertion order in one pass, which is
+    // much cheaper than add() for large armies that keep cowboys first.
+    Army::Army(std::vector<Fighter> fighters, Ordering ordering, int leader)
+            : members(std::move(fighters)), size((int) members.size()), ordering(ordering) {
+        if (leader < 0 || (size > 0 && leader >= size)) {
+            throw std::invalid_argument("leader is not a member of the army");
+        }
+        if (ordering == Ordering::CowboysFirst && size > 0) {
+            const Fighter chosen = members[(size_t) leader];
+            int before = 0;
+            for (int i = 0; i < leader; ++i) {
+                before += members[(size_t) i].isCowboy() == chosen.isCowboy() ? 1 : 0;
+            }
+            auto cowboys = std::stable_partition(members.begin(), members.end(),
+                                                 [](const Fighter &fighter) { return fighter.isCowboy(); });
+            leader = before + (chosen.isCowboy() ? 0 : (int) (cowboys - members.begin()));
+        }
+        this->leader = leader;
+    }
+
+    void Army::add(Kind kind, double x, double y) {
+        add(Fighter{x, y, startingHealth(kind), kind == Kind::Cowboy ? COWBOY_BULLETS : 0, kind});
+    }
+
+    void Army::add(const Fighter &fighter) {
+        int position = size;
+        if (ordering == Ordering::CowboysFirst && fighter.isCowboy()) {
+            position = (int) (std::find_if(members.begin(), members.end(),
+                                           [](const Fighter &member) { return !member.isCowboy(); }) - members.begin());
+        }
+        members.insert(members.begin() + position, fighter);
+        if (size > 0 && position <= leader) {
+            leader++;
+        }
+        size++;
+    }
+
+    int Army::stillAlive() const {
+        return (int) std::count_if(members.begin(), members.end(), [](const Fighter &member) { return member.isAlive(); });
+    }
+
+    int Army::totalHealth() const {
+        int health = 0;
+        for (const Fighter &member: members) {
+            health += std::max(member.health, 0);
+        }
+        return health;
+    }
+
+    int Army::closestAlive(double x, double y) const {
+        int closest = -1;
+        double best = 0;
+        for (int i = 0; i < size; ++i) {
+            const Fighter &member = members[(size_t) i];
+            if (!member.isAlive()) {
+                continue;
+            }
+            double length = distance(x, y, member.x, member.y);
+            if (closest < 0 || length < best) {
+                closest = i;
+                best = length;
+            }
+        }
+        return closest;
+    }
+
+} // ariel
@@ -0,0 +1,45 @@
+//
+// Created by avida on 5/21/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_ARMY_H
+#define COWBOY_VS_NINJA_A_ARMY_H
+
+#include "Match.hpp"
+#include <vector>
+
+namespace ariel {
+
+    // A roster without the ten member cap, for large battles. It keeps the
+    // same members/size/leader layout as Roster, so Match::attack plays it
+    // unchanged.
+    struct Army {
+        std::vector<Fighter> members;
+        int size = 0;
+        int leader = 0;
+        Ordering ordering = Ordering::CowboysFirst;
+
+        Army() = default;
+        explicit Army(Ordering ordering) : ordering(ordering) {}
+        explicit Army(const Roster &roster);
+        Army(std::vector<Fighter> fighters, Ordering ordering, int leader = 0);
+
+        void add(Kind kind, double x, double y);
+        void add(const Fighter &fighter);
+        int stillAlive() const;
+        int totalHealth() const;
+        int closestAlive(double x, double y) const;
+    };
+
+    struct Battle {
+        Army first;
+        Army second;
+
+        Battle() = default;
+        Battle(Army first, Army second) : first(std::move(first)), second(std::move(second)) {}
+        explicit Battle(const Scenario &scenario) : first(scenario.first), second(scenario.second) {}
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_ARMY_H
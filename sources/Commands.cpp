@@ -0,0 +1,132 @@
+//
+// Created by avida on 5/26/2023.
+//
+
+#include "Commands.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace ariel {
+
+    CommandQueue::CommandQueue() {
+        for (std::uint64_t i = 0; i < CAPACITY; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool CommandQueue::push(const Command &command) {
+        std::uint64_t position = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[position % CAPACITY];
+            auto difference = (std::int64_t) (cell.sequence.load(std::memory_order_acquire) - position);
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.command = command;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool CommandQueue::pop(Command &command) {
+        Cell &cell = cells[head % CAPACITY];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+        command = cell.command;
+        cell.sequence.store(head + CAPACITY, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    namespace {
+        // Hands the attack the victim a command picked, once.
+        struct VictimOverride : NoObserver {
+            int victim;
+
+            template <class Side>
+            int pickVictim(const Side & /*defenders*/) { return std::exchange(victim, -1); }
+        };
+    }
+
+    static bool living(const Roster &roster, int member) {
+        return member >= 0 && member < roster.size && roster.members[(size_t) member].isAlive();
+    }
+
+    bool Commander::apply(Scenario &scenario, const Command &command) {
+        if (command.team != 0 && command.team != 1) {
+            return false;
+        }
+        Roster &own = command.team == 0 ? scenario.first : scenario.second;
+        Roster &enemy = command.team == 0 ? scenario.second : scenario.first;
+        switch (command.order) {
+            case Order::Leader:
+                if (!living(own, command.member)) {
+                    return false;
+                }
+                own.leader = command.member;
+                return true;
+            case Order::Victim:
+                if (!living(enemy, command.member)) {
+                    return false;
+                }
+                victims[(size_t) command.team] = command.member;
+                return true;
+            case Order::Reinforce: {
+                if (command.kind > Kind::OldNinja) {
+                    return false;
+                }
+                // Members from the new slot on move one slot down.
+                int position = 0;
+                try {
+                    position = own.add(command.kind, command.x, command.y);
+                } catch (const std::runtime_error &) {
+                    return false;
+                }
+                int &marked = victims[(size_t) (1 - command.team)];
+                if (marked >= position) {
+                    marked++;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Commander::drainAll(Scenario &scenario) {
+        Command command;
+        while (queue.pop(command)) {
+            if (apply(scenario, command)) {
+                applied++;
+            } else {
+                rejected++;
+            }
+        }
+    }
+
+    void Commander::attack(Scenario &scenario, int team) {
+        drain(scenario);
+        VictimOverride observer{{}, std::exchange(victims[(size_t) team], -1)};
+        if (team == 0) {
+            Match::attack(scenario.first, scenario.second, observer);
+        } else {
+            Match::attack(scenario.second, scenario.first, observer);
+        }
+    }
+
+    Outcome Commander::play(Scenario &scenario, int maxRounds) {
+        int rounds = 0;
+        while (rounds < maxRounds && scenario.first.stillAlive() > 0 && scenario.second.stillAlive() > 0) {
+            attack(scenario, 0);
+            attack(scenario, 1);
+            rounds++;
+        }
+        return Match::result(scenario, rounds);
+    }
+
+} // ariel
@@ -0,0 +1,90 @@
+//
+// Created by avida on 5/26/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_COMMANDS_H
+#define COWBOY_VS_NINJA_A_COMMANDS_H
+
+#include "Match.hpp"
+#include <atomic>
+#include <cstdint>
+
+namespace ariel {
+
+    enum class Order : unsigned char { Leader, Reinforce, Victim };
+
+    // An order for one team. Leader names one of its own members, Victim a
+    // member of the enemy team to attack first on its next attack, and
+    // Reinforce adds a fresh fighter of kind at (x, y).
+    struct Command {
+        Order order = Order::Leader;
+        int team = 0;
+        int member = 0;
+        Kind kind = Kind::Cowboy;
+        double x = 0;
+        double y = 0;
+    };
+
+    // Bounded lock-free queue for any number of producers and one consumer,
+    // the bounded ring of ProcessBatch with a consumer that owns the head.
+    class CommandQueue {
+    public:
+        static constexpr std::uint64_t CAPACITY = 256;
+
+    private:
+        struct Cell {
+            std::atomic<std::uint64_t> sequence;
+            Command command;
+        };
+
+        alignas(64) std::atomic<std::uint64_t> tail{0};
+        alignas(64) std::uint64_t head = 0;
+        std::array<Cell, CAPACITY> cells;
+
+    public:
+        CommandQueue();
+        CommandQueue(const CommandQueue &) = delete;
+        CommandQueue &operator=(const CommandQueue &) = delete;
+
+        // Any thread; false when the queue is full.
+        bool push(const Command &command);
+        // Consumer only.
+        bool pop(Command &command);
+        bool empty() const {
+            return cells[head % CAPACITY].sequence.load(std::memory_order_acquire) != head + 1;
+        }
+    };
+
+    // Plays a match attack by attack on one thread while other threads send
+    // it commands. The queue is drained before every attack, and each command
+    // is checked against the state at that moment with the rules of the
+    // direct API: leaders and victims must be living members, and
+    // reinforcements go through Roster::add. An empty queue costs one load
+    // per attack.
+    class Commander {
+        CommandQueue queue;
+        std::array<int, 2> victims{-1, -1};
+        std::uint64_t applied = 0;
+        std::uint64_t rejected = 0;
+
+    public:
+        bool submit(const Command &command) { return queue.push(command); }
+
+        // Engine thread only. Returns whether the command was valid.
+        bool apply(Scenario &scenario, const Command &command);
+        void drain(Scenario &scenario) {
+            if (!queue.empty()) {
+                drainAll(scenario);
+            }
+        }
+        void drainAll(Scenario &scenario);
+        void attack(Scenario &scenario, int team);
+        Outcome play(Scenario &scenario, int maxRounds = MAX_ROUNDS);
+
+        std::uint64_t appliedCount() const { return applied; }
+        std::uint64_t rejectedCount() const { return rejected; }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_COMMANDS_H
@@ -0,0 +1,125 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#include "CowboyNinja.h"
+#include "Match.hpp"
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace ariel;
+
+// The C structs are the C++ ones seen from outside, so batches are passed
+// through as they are instead of being copied into and out of the library.
+static_assert(std::is_standard_layout_v<Fighter> && std::is_standard_layout_v<Roster> &&
+              std::is_standard_layout_v<Scenario> && std::is_standard_layout_v<Outcome>);
+static_assert(sizeof(cn_fighter) == sizeof(Fighter) && offsetof(cn_fighter, x) == offsetof(Fighter, x) &&
+              offsetof(cn_fighter, y) == offsetof(Fighter, y) &&
+              offsetof(cn_fighter, health) == offsetof(Fighter, health) &&
+              offsetof(cn_fighter, bullets) == offsetof(Fighter, bullets) &&
+              offsetof(cn_fighter, kind) == offsetof(Fighter, kind));
+static_assert(sizeof(cn_team) == sizeof(Roster) && CN_MAX_MEMBERS == MAX_MEMBERS &&
+              offsetof(cn_team, members) == offsetof(Roster, members) &&
+              offsetof(cn_team, size) == offsetof(Roster, size) &&
+              offsetof(cn_team, leader) == offsetof(Roster, leader) &&
+              offsetof(cn_team, ordering) == offsetof(Roster, ordering));
+static_assert(sizeof(cn_scenario) == sizeof(Scenario) && offsetof(cn_scenario, second) == offsetof(Scenario, second));
+static_assert(sizeof(cn_outcome) == sizeof(Outcome) && offsetof(cn_outcome, winner) == offsetof(Outcome, winner) &&
+              offsetof(cn_outcome, rounds) == offsetof(Outcome, rounds) &&
+              offsetof(cn_outcome, alive_first) == offsetof(Outcome, aliveFirst) &&
+              offsetof(cn_outcome, alive_second) == offsetof(Outcome, aliveSecond) &&
+              offsetof(cn_outcome, health_first) == offsetof(Outcome, healthFirst) &&
+              offsetof(cn_outcome, health_second) == offsetof(Outcome, healthSecond));
+static_assert((int) Kind::OldNinja == CN_OLD_NINJA && (int) Ordering::Insertion == CN_INSERTION &&
+              (int) Winner::Undecided == CN_UNDECIDED);
+
+static bool validTeam(const cn_team &team) {
+    return reinterpret_cast<const Roster &>(team).isValid();
+}
+
+static MatchOptions toOptions(const cn_options *options) {
+    MatchOptions converted;
+    if (options != nullptr) {
+        converted.maxRounds = options->max_rounds;
+        converted.skipQuietRounds = options->skip_quiet_rounds != 0;
+        converted.resolveVolleys = options->resolve_volleys != 0;
+        converted.resolveEndgames = options->resolve_endgames != 0;
+    }
+    return converted;
+}
+
+// Exceptions must not cross into C.
+template <class Body>
+static int guarded(Body body) {
+    try {
+        body();
+        return CN_OK;
+    } catch (const std::invalid_argument &) {
+        return CN_INVALID_ARGUMENT;
+    } catch (...) {
+        return CN_INTERNAL_ERROR;
+    }
+}
+
+extern "C" {
+
+uint32_t cn_abi_version(void) {
+    return CN_ABI_VERSION;
+}
+
+void cn_default_options(cn_options *options) {
+    if (options == nullptr) {
+        return;
+    }
+    MatchOptions defaults;
+    options->max_rounds = defaults.maxRounds;
+    options->skip_quiet_rounds = defaults.skipQuietRounds ? 1 : 0;
+    options->resolve_volleys = defaults.resolveVolleys ? 1 : 0;
+    options->resolve_endgames = defaults.resolveEndgames ? 1 : 0;
+}
+
+int cn_team_init(cn_team *team, int ordering) {
+    if (team == nullptr || ordering < CN_COWBOYS_FIRST || ordering > CN_INSERTION) {
+        return CN_INVALID_ARGUMENT;
+    }
+    new (team) Roster(static_cast<Ordering>(ordering));
+    return CN_OK;
+}
+
+int cn_team_add(cn_team *team, int kind, double x, double y) {
+    if (team == nullptr || kind < CN_COWBOY || kind > CN_OLD_NINJA || !isFinite(x) || !isFinite(y)) {
+        return CN_INVALID_ARGUMENT;
+    }
+    if (team->size >= CN_MAX_MEMBERS) {
+        return CN_TEAM_FULL;
+    }
+    return guarded([&] { reinterpret_cast<Roster *>(team)->add(static_cast<Kind>(kind), x, y); });
+}
+
+int cn_play(const cn_scenario *scenario, cn_outcome *outcome, const cn_options *options) {
+    return cn_play_batch(scenario, outcome, 1, 1, options);
+}
+
+int cn_play_batch(const cn_scenario *scenarios, cn_outcome *outcomes, size_t count, unsigned threads,
+                  const cn_options *options) {
+    if (count == 0) {
+        return CN_OK;
+    }
+    if (scenarios == nullptr || outcomes == nullptr || (options != nullptr && options->max_rounds < 0)) {
+        return CN_INVALID_ARGUMENT;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!validTeam(scenarios[i].first) || !validTeam(scenarios[i].second)) {
+            return CN_INVALID_ARGUMENT;
+        }
+    }
+    return guarded([&] {
+        Match::playBatch({reinterpret_cast<const Scenario *>(scenarios), count},
+                         {reinterpret_cast<Outcome *>(outcomes), count}, threads, toOptions(options));
+    });
+}
+
+}
@@ -0,0 +1,94 @@
+/*
+ * Created by avida on 5/25/2023.
+ *
+ * C interface of libcowboyninja.so. Every buffer belongs to the caller: the
+ * library reads scenarios and writes outcomes in place and never hands out
+ * memory or strings, so a whole batch crosses the boundary in one call.
+ * Inside, only cn_play_batch allocates, to start threads for the batch.
+ * Structs are plain data with fixed width fields; CN_ABI_VERSION changes
+ * whenever their layout or a signature does.
+ */
+
+#ifndef COWBOY_VS_NINJA_A_COWBOYNINJA_H
+#define COWBOY_VS_NINJA_A_COWBOYNINJA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CN_API __attribute__((visibility("default")))
+#define CN_ABI_VERSION 1U
+#define CN_MAX_MEMBERS 10
+
+enum { CN_COWBOY = 0, CN_YOUNG_NINJA = 1, CN_TRAINED_NINJA = 2, CN_OLD_NINJA = 3 };
+enum { CN_COWBOYS_FIRST = 0, CN_INSERTION = 1 };
+enum { CN_FIRST = 0, CN_SECOND = 1, CN_UNDECIDED = 2 };
+
+enum {
+    CN_OK = 0,
+    CN_TEAM_FULL = -1,
+    CN_INVALID_ARGUMENT = -2,
+    CN_INTERNAL_ERROR = -3
+};
+
+typedef struct cn_fighter {
+    double x;
+    double y;
+    int32_t health;
+    int32_t bullets;
+    uint8_t kind;
+} cn_fighter;
+
+/* Members are kept in traversal order; build teams with cn_team_add. */
+typedef struct cn_team {
+    cn_fighter members[CN_MAX_MEMBERS];
+    int32_t size;
+    int32_t leader;
+    uint8_t ordering;
+} cn_team;
+
+typedef struct cn_scenario {
+    cn_team first;
+    cn_team second;
+} cn_scenario;
+
+typedef struct cn_outcome {
+    uint8_t winner;
+    int32_t rounds;
+    int32_t alive_first;
+    int32_t alive_second;
+    int32_t health_first;
+    int32_t health_second;
+} cn_outcome;
+
+typedef struct cn_options {
+    int32_t max_rounds;
+    uint8_t skip_quiet_rounds;
+    uint8_t resolve_volleys;
+    uint8_t resolve_endgames;
+} cn_options;
+
+CN_API uint32_t cn_abi_version(void);
+CN_API void cn_default_options(cn_options *options);
+
+/* Empties the team; ordering is CN_COWBOYS_FIRST or CN_INSERTION. */
+CN_API int cn_team_init(cn_team *team, int ordering);
+/* Adds a fresh fighter. The first one added leads. */
+CN_API int cn_team_add(cn_team *team, int kind, double x, double y);
+
+/* options may be NULL for the defaults. */
+CN_API int cn_play(const cn_scenario *scenario, cn_outcome *outcome, const cn_options *options);
+/* Plays count scenarios on up to threads threads, 0 meaning one per core,
+ * writing outcomes[i] for scenarios[i]. Nothing is played when any scenario
+ * is malformed. */
+CN_API int cn_play_batch(const cn_scenario *scenarios, cn_outcome *outcomes, size_t count, unsigned threads,
+                         const cn_options *options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COWBOY_VS_NINJA_A_COWBOYNINJA_H */
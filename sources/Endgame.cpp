@@ -0,0 +1,75 @@
+//
+// Created by avida on 5/20/2023.
+//
+
+#include "Endgame.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace ariel {
+
+    // One constant per pair of duelists, to stay well inside the compilers'
+    // constant evaluation step limits, and a row of pointers to them.
+    template <size_t PAIR>
+    static constexpr std::array<Duel, Endgame::PAIR_DUELS> PAIR_TABLE =
+            Endgame::duels((int) PAIR / Endgame::DESCRIPTORS, (int) PAIR % Endgame::DESCRIPTORS);
+
+    template <size_t... PAIRS>
+    static constexpr std::array<const Duel *, sizeof...(PAIRS)> pairTables(std::index_sequence<PAIRS...> /*pairs*/) {
+        return {PAIR_TABLE<PAIRS>.data()...};
+    }
+
+    static constexpr auto DUELS = pairTables(std::make_index_sequence<(size_t) (Endgame::DESCRIPTORS *
+                                                                                 Endgame::DESCRIPTORS)>());
+
+    const Endgame &Endgame::instance() {
+        static const Endgame endgame;
+        return endgame;
+    }
+
+    int Endgame::descriptor(const Duelist &duelist) {
+        if (duelist.kind == Kind::Cowboy) {
+            return duelist.bullets >= 0 && duelist.bullets <= COWBOY_BULLETS ? duelist.bullets : -1;
+        }
+        return duelist.firstSlash >= 1 && duelist.firstSlash <= MAX_APPROACH ? COWBOY_BULLETS + duelist.firstSlash : -1;
+    }
+
+    int Endgame::hitsNeeded(const Duelist &attacker, int health) {
+        int hits = (health + attacker.hitDamage() - 1) / attacker.hitDamage();
+        return hits <= MAX_HITS ? hits : -1;
+    }
+
+    Duel Endgame::lookup(const Duelist &first, int firstHealth, const Duelist &second, int secondHealth) const {
+        int one = descriptor(first);
+        int other = descriptor(second);
+        int hits = hitsNeeded(first, secondHealth);
+        int taken = hitsNeeded(second, firstHealth);
+        if (one < 0 || other < 0 || hits < 0 || taken < 0) {
+            return fight(first, firstHealth, second, secondHealth);
+        }
+        return DUELS[(size_t) (one * DESCRIPTORS + other)][(size_t) ((hits - 1) * MAX_HITS + taken - 1)];
+    }
+
+    bool Endgame::resolve(const Scenario &scenario, int rounds, int maxRounds, Outcome &outcome) const {
+        if (scenario.first.stillAlive() != 1 || scenario.second.stillAlive() != 1) {
+            return false;
+        }
+        const Fighter &first = scenario.first.members[(size_t) scenario.first.closestAlive(0, 0)];
+        const Fighter &second = scenario.second.members[(size_t) scenario.second.closestAlive(0, 0)];
+        Duelist one{};
+        Duelist other{};
+        if (!approach(first, second, one, other, maxRounds - rounds)) {
+            return false;
+        }
+        Duel duel = lookup(one, first.health, other, second.health);
+        if (rounds + duel.rounds > maxRounds) {
+            return false;
+        }
+        bool firstWins = duel.winner == Winner::First;
+        outcome = Outcome{duel.winner, rounds + duel.rounds, firstWins ? 1 : 0, firstWins ? 0 : 1,
+                          std::max(first.health - duel.damageSecond, 0),
+                          std::max(second.health - duel.damageFirst, 0)};
+        return true;
+    }
+
+} // ariel
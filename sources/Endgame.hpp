@@ -0,0 +1,140 @@
+//
+// Created by avida on 5/20/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_ENDGAME_H
+#define COWBOY_VS_NINJA_A_ENDGAME_H
+
+#include "Match.hpp"
+#include "FastForward.hpp"
+#include <array>
+
+namespace ariel {
+
+    // How one duelist deals damage once it is alone: a cowboy by the bullets in
+    // its gun, a ninja by the round of its first slash (its distance to the
+    // enemy, discretized to whole turns of walking).
+    struct Duelist {
+        Kind kind;
+        int bullets;
+        int firstSlash;
+
+        constexpr int hitDamage() const { return kind == Kind::Cowboy ? BULLET_DAMAGE : SLASH_DAMAGE; }
+
+        constexpr int roundsToKill(int health) const {
+            int hits = (health + hitDamage() - 1) / hitDamage();
+            if (kind != Kind::Cowboy) {
+                return firstSlash + hits - 1;
+            }
+            if (hits <= bullets) {
+                return hits;
+            }
+            int reloaded = hits - bullets - 1;
+            return bullets + 1 + reloaded / COWBOY_BULLETS * (COWBOY_BULLETS + 1) + reloaded % COWBOY_BULLETS + 1;
+        }
+
+        constexpr int damageAfter(int rounds) const {
+            if (kind == Kind::Cowboy) {
+                return BULLET_DAMAGE * FastForward::shots(rounds, bullets);
+            }
+            return rounds < firstSlash ? 0 : SLASH_DAMAGE * (rounds - firstSlash + 1);
+        }
+    };
+
+    struct Duel {
+        Winner winner;
+        int rounds;
+        int damageFirst;
+        int damageSecond;
+    };
+
+    // Closed form result of a match reduced to one fighter on each side. Both
+    // duelists stand still once the ninjas are in range, so only the walk up to
+    // the first slash is played step by step. Duels whose ninjas need at most
+    // MAX_APPROACH rounds to reach their victim are looked up in a table
+    // indexed by kind, bullets, first slash round and the number of hits each
+    // side needs, which the compiler works out and bakes into the binary.
+    class Endgame {
+        static int descriptor(const Duelist &duelist);
+        static int hitsNeeded(const Duelist &attacker, int health);
+
+    public:
+        static constexpr int MAX_APPROACH = 16;
+        static constexpr int MAX_HITS = 15;
+        static constexpr int DESCRIPTORS = COWBOY_BULLETS + 1 + MAX_APPROACH;
+        static constexpr size_t PAIR_DUELS = (size_t) (MAX_HITS * MAX_HITS);
+
+        static constexpr std::array<Duel, PAIR_DUELS> duels(int firstDescriptor, int secondDescriptor);
+        static const Endgame &instance();
+
+        static constexpr Duel fight(const Duelist &first, int firstHealth, const Duelist &second, int secondHealth);
+        static constexpr bool approach(Fighter first, Fighter second, Duelist &one, Duelist &other, int limit);
+        Duel lookup(const Duelist &first, int firstHealth, const Duelist &second, int secondHealth) const;
+        bool resolve(const Scenario &scenario, int rounds, int maxRounds, Outcome &outcome) const;
+    };
+
+    constexpr Duel Endgame::fight(const Duelist &first, int firstHealth, const Duelist &second, int secondHealth) {
+        int firstKills = first.roundsToKill(secondHealth);
+        int secondKills = second.roundsToKill(firstHealth);
+        if (firstKills <= secondKills) {
+            return Duel{Winner::First, firstKills, first.damageAfter(firstKills), second.damageAfter(firstKills - 1)};
+        }
+        return Duel{Winner::Second, secondKills, first.damageAfter(secondKills), second.damageAfter(secondKills)};
+    }
+
+    // The duels of one pair of duelists, indexed by the hits each one needs.
+    constexpr std::array<Duel, Endgame::PAIR_DUELS> Endgame::duels(int firstDescriptor, int secondDescriptor) {
+        auto duelist = [](int descriptor) {
+            return descriptor <= COWBOY_BULLETS ? Duelist{Kind::Cowboy, descriptor, 0}
+                                                : Duelist{Kind::OldNinja, 0, descriptor - COWBOY_BULLETS};
+        };
+        Duelist first = duelist(firstDescriptor);
+        Duelist second = duelist(secondDescriptor);
+        std::array<Duel, PAIR_DUELS> pair{};
+        for (int hits = 1; hits <= MAX_HITS; ++hits) {
+            for (int taken = 1; taken <= MAX_HITS; ++taken) {
+                pair[(size_t) ((hits - 1) * MAX_HITS + taken - 1)] =
+                        fight(first, taken * second.hitDamage(), second, hits * first.hitDamage());
+            }
+        }
+        return pair;
+    }
+
+    // Walks the ninjas towards each other turn by turn, recording the round in
+    // which each one first finds its enemy within slashing range. A ninja
+    // still walking once its enemy has killed it never slashes; it stops there
+    // with its first slash set to the round after its death, which fight()
+    // scores the same as any later one.
+    constexpr bool Endgame::approach(Fighter first, Fighter second, Duelist &one, Duelist &other, int limit) {
+        one = Duelist{first.kind, first.bullets, first.isCowboy() ? 1 : 0};
+        other = Duelist{second.kind, second.bullets, second.isCowboy() ? 1 : 0};
+        for (int round = 1; round <= limit && (one.firstSlash == 0 || other.firstSlash == 0); ++round) {
+            if (one.firstSlash == 0 && other.firstSlash != 0 && round > other.roundsToKill(first.health)) {
+                one.firstSlash = round;
+                break;
+            }
+            if (other.firstSlash == 0 && one.firstSlash != 0 && round > one.roundsToKill(second.health)) {
+                other.firstSlash = round;
+                break;
+            }
+            if (one.firstSlash == 0) {
+                if (distance(first, second) < SLASH_RANGE) {
+                    one.firstSlash = round;
+                } else {
+                    moveTowards(first, second, speedOf(first.kind));
+                }
+            }
+            if (other.firstSlash == 0) {
+                if (distance(second, first) < SLASH_RANGE) {
+                    other.firstSlash = round;
+                } else {
+                    moveTowards(second, first, speedOf(second.kind));
+                }
+            }
+        }
+        return one.firstSlash != 0 && other.firstSlash != 0;
+    }
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_ENDGAME_H
@@ -0,0 +1,313 @@
+//
+// Created by avida on 5/21/2023.
+//
+
+#include "EventEngine.hpp"
+#include "FastForward.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace ariel {
+
+    // An army of the engine as Match::attack sees it: living members come
+    // from the count and the closest member from the index.
+    struct EventEngine::View {
+        EventEngine &engine;
+        std::vector<Fighter> &members;
+        int size;
+        int &leader;
+        int team;
+
+        int stillAlive() const { return engine.sides[(size_t) team].alive; }
+
+        int closestAlive(double x, double y) const {
+            return engine.grid.closestMember(engine.teams, team, x, y).member;
+        }
+    };
+
+    // Keeps the counts and the index in step with every act of an attack.
+    struct EventEngine::Tracker : NoObserver {
+        EventEngine &engine;
+        std::array<Fighter, 2> before{};
+
+        explicit Tracker(EventEngine &engine) : engine(engine) {}
+
+        void changing(const View &side, int member) { before[(size_t) side.team] = side.members[(size_t) member]; }
+        void changed(const View &side, int member) { engine.update(side.team, member, before[(size_t) side.team]); }
+    };
+
+    void EventEngine::push(int side, long turn) {
+        queue.push(Event{turn, sides[(size_t) side].version});
+    }
+
+    void EventEngine::update(int side, int member, const Fighter &before) {
+        const Fighter &fighter = teams[(size_t) side].members[(size_t) member];
+        Side &state = sides[(size_t) side];
+        if (fighter.health != before.health) {
+            state.health -= std::max(before.health, 0) - std::max(fighter.health, 0);
+            if (before.isAlive() && !fighter.isAlive()) {
+                state.alive--;
+                grid.remove(SpatialIndex::Entry{side, member});
+            }
+        }
+        if (fighter.isAlive() && (fighter.x != before.x || fighter.y != before.y)) {
+            grid.move(fighter, SpatialIndex::Entry{side, member});
+        }
+    }
+
+    // What a sleeping army deals its victim over its first turns asleep.
+    long EventEngine::damage(const Side &side, long turns) const {
+        long total = (long) SLASH_DAMAGE * side.slashers * turns;
+        for (int bullets = 0; bullets <= COWBOY_BULLETS; ++bullets) {
+            total += (long) BULLET_DAMAGE * side.cowboys[(size_t) bullets] * FastForward::shots((int) turns, bullets);
+        }
+        return total;
+    }
+
+    // Applies the own turns a sleeping army took before turn: the damage to
+    // its victim in closed form and one step per turn for each walker.
+    void EventEngine::strike(int index, long turn) {
+        Side &side = sides[(size_t) index];
+        if (!side.dormant || turn <= side.caughtUp) {
+            return;
+        }
+        long turns = (turn - side.caughtUp + 1) / 2;
+        Fighter &victim = teams[(size_t) (1 - index)].members[(size_t) side.victim];
+        Fighter before = victim;
+        victim.health -= (int) (damage(side, side.slept + turns) - damage(side, side.slept));
+        update(1 - index, side.victim, before);
+        for (int walker: side.walkers) {
+            Fighter &ninja = teams[(size_t) index].members[(size_t) walker];
+            if (!ninja.isAlive()) {
+                continue;
+            }
+            Fighter start = ninja;
+            for (long step = 0; step < turns; ++step) {
+                moveTowards(ninja, victim, speedOf(ninja.kind));
+            }
+            update(index, walker, start);
+        }
+        side.slept += turns;
+        side.caughtUp += 2 * turns;
+    }
+
+    void EventEngine::wake(int index, long turn) {
+        strike(index, turn);
+        Side &side = sides[(size_t) index];
+        if (!side.dormant) {
+            return;
+        }
+        for (Fighter &member: teams[(size_t) index].members) {
+            if (member.isAlive() && member.isCowboy()) {
+                member.bullets = FastForward::bulletsAfter((int) side.slept, member.bullets);
+            }
+        }
+        side.dormant = false;
+        side.slept = 0;
+    }
+
+    // Own turns until the one that kills the victim, or `limit` if it survives
+    // them all.
+    int EventEngine::turnsToKill(int index, long limit) const {
+        const Side &side = sides[(size_t) index];
+        int health = teams[(size_t) (1 - index)].members[(size_t) side.victim].health;
+        long low = 1;
+        long high = limit;
+        if (damage(side, high) < health) {
+            return (int) limit;
+        }
+        while (low < high) {
+            long middle = low + (high - low) / 2;
+            if (damage(side, middle) >= health) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        return (int) low;
+    }
+
+    // Puts the army to sleep for as many own turns as its plan is sure to
+    // hold, or schedules its next turn when that is fewer than two. With the
+    // enemy asleep as well nobody checks on either plan in between, so the
+    // walkers of each side must not come closer to the other's leader than
+    // its victim, and no walker may be a victim.
+    void EventEngine::plan(int index, long turn, long end) {
+        Side &side = sides[(size_t) index];
+        const Side &other = sides[(size_t) (1 - index)];
+        const Army &own = teams[(size_t) index];
+        const Army &enemy = teams[(size_t) (1 - index)];
+        long limit = (end - turn + 1) / 2;
+        const Fighter &leader = own.members[(size_t) own.leader];
+        if (schedule == Schedule::LockStep || limit < 2 || !leader.isAlive() || other.alive == 0) {
+            push(index, turn + 2);
+            return;
+        }
+        side.victim = grid.closestMember(teams, 1 - index, leader.x, leader.y).member;
+        const Fighter &victim = enemy.members[(size_t) side.victim];
+        side.slashers = 0;
+        side.cowboys = {};
+        side.walkers.clear();
+        long turns = limit;
+        for (int i = 0; i < own.size; ++i) {
+            const Fighter &member = own.members[(size_t) i];
+            if (!member.isAlive()) {
+                continue;
+            }
+            if (member.isCowboy()) {
+                if (member.bullets < 0 || member.bullets > COWBOY_BULLETS) {
+                    push(index, turn + 2);
+                    return;
+                }
+                side.cowboys[(size_t) member.bullets]++;
+                continue;
+            }
+            double reach = distance(member, victim);
+            if (reach < SLASH_RANGE) {
+                side.slashers++;
+                continue;
+            }
+            if (i == own.leader || (other.dormant && i == other.victim)) {
+                push(index, turn + 2);
+                return;
+            }
+            // Against a standing victim it walks on every turn on which what it
+            // has covered leaves it SLASH_RANGE away.
+            double speed = speedOf(member.kind);
+            turns = std::min(turns, (long) std::floor((reach - SLASH_RANGE - margin) / speed) + 2);
+            if (other.dormant) {
+                const Fighter &watcher = enemy.members[(size_t) enemy.leader];
+                double room = distance(watcher, member) - distance(watcher, own.members[(size_t) other.victim]);
+                turns = std::min(turns, (long) std::floor((room - margin) / speed));
+            }
+            side.walkers.push_back(i);
+        }
+        if (other.dormant) {
+            double apart = distance(leader, victim);
+            for (int walker: other.walkers) {
+                const Fighter &member = enemy.members[(size_t) walker];
+                if (walker == side.victim) {
+                    push(index, turn + 2);
+                    return;
+                }
+                if (member.isAlive()) {
+                    double room = distance(leader, member) - apart;
+                    turns = std::min(turns, (long) std::floor((room - margin) / speedOf(member.kind)));
+                }
+            }
+        }
+        turns = std::min(turns, (long) turnsToKill(index, limit));
+        if (turns < 2) {
+            push(index, turn + 2);
+            return;
+        }
+        side.dormant = true;
+        side.caughtUp = turn + 2;
+        side.slept = 0;
+        side.planned = side.alive;
+        side.victimX = victim.x;
+        side.victimY = victim.y;
+        push(index, turn + 2L * turns);
+    }
+
+    bool EventEngine::disturbed(int index) const {
+        const Side &side = sides[(size_t) index];
+        const Army &own = teams[(size_t) index];
+        const Fighter &leader = own.members[(size_t) own.leader];
+        const Fighter &victim = teams[(size_t) (1 - index)].members[(size_t) side.victim];
+        if (side.alive != side.planned) {
+            return true;
+        }
+        bool ninjas = side.slashers > 0 || !side.walkers.empty();
+        if (ninjas && (victim.x != side.victimX || victim.y != side.victimY)) {
+            return true;
+        }
+        return grid.closestMember(teams, 1 - index, leader.x, leader.y).member != side.victim;
+    }
+
+    Outcome EventEngine::result(int rounds) const {
+        int aliveFirst = sides[0].alive;
+        int aliveSecond = sides[1].alive;
+        Winner winner = Winner::Undecided;
+        if (aliveSecond == 0 && aliveFirst > 0) {
+            winner = Winner::First;
+        } else if (aliveFirst == 0 && aliveSecond > 0) {
+            winner = Winner::Second;
+        }
+        return Outcome{winner, rounds, aliveFirst, aliveSecond, sides[0].health, sides[1].health};
+    }
+
+    // The armies are swapped into the engine for the match, so the index can
+    // hold them as teams, and swapped back when it ends.
+    Outcome EventEngine::play(Battle &battle, int maxRounds) {
+        teams.resize(2);
+        std::swap(teams[0], battle.first);
+        std::swap(teams[1], battle.second);
+        Outcome outcome = run(maxRounds);
+        std::swap(teams[0], battle.first);
+        std::swap(teams[1], battle.second);
+        return outcome;
+    }
+
+    Outcome EventEngine::run(int maxRounds) {
+        double largest = 1;
+        for (size_t index = 0; index < sides.size(); ++index) {
+            Side &side = sides[index];
+            std::vector<int> walkers = std::move(side.walkers);
+            walkers.clear();
+            side = Side{};
+            side.walkers = std::move(walkers);
+            for (const Fighter &member: teams[index].members) {
+                if (member.isAlive()) {
+                    side.alive++;
+                    side.health += member.health;
+                }
+                largest = std::max({largest, std::abs(member.x), std::abs(member.y)});
+            }
+        }
+        // Slack for rounding, as in FastForward.
+        margin = largest * 1e-9;
+        queue.clear();
+        processed = 0;
+        if (sides[0].alive == 0 || sides[1].alive == 0 || maxRounds <= 0) {
+            return result(0);
+        }
+        grid.reset(teams, SpatialIndex::defaultCellSize(teams));
+        long end = 2L * maxRounds;
+        push(0, 0);
+        push(1, 1);
+        while (true) {
+            Event event = queue.pop();
+            int index = (int) (event.turn % 2);
+            int other = 1 - index;
+            if (event.version != sides[(size_t) index].version) {
+                continue;
+            }
+            if (event.turn >= end) {
+                wake(index, end);
+                wake(other, end);
+                return result(maxRounds);
+            }
+            wake(index, event.turn);
+            strike(other, event.turn);
+            Army &attacking = teams[(size_t) index];
+            Army &defending = teams[(size_t) other];
+            View attackers{*this, attacking.members, attacking.size, attacking.leader, index};
+            View defenders{*this, defending.members, defending.size, defending.leader, other};
+            Tracker tracker(*this);
+            Match::attack(attackers, defenders, tracker);
+            processed++;
+            if (sides[(size_t) other].alive == 0) {
+                wake(other, event.turn);
+                return result((int) (event.turn / 2 + 1));
+            }
+            if (sides[(size_t) other].dormant && disturbed(other)) {
+                wake(other, event.turn + 1);
+                sides[(size_t) other].version++;
+                push(other, event.turn + 1);
+            }
+            plan(index, event.turn, end);
+        }
+    }
+
+} // ariel
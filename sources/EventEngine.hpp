@@ -0,0 +1,92 @@
+//
+// Created by avida on 5/21/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_EVENTENGINE_H
+#define COWBOY_VS_NINJA_A_EVENTENGINE_H
+
+#include "Army.hpp"
+#include "PairingHeap.hpp"
+#include "SpatialIndex.hpp"
+#include <array>
+#include <vector>
+
+namespace ariel {
+
+    enum class Schedule : unsigned char { LockStep, Sparse };
+
+    // Plays a Battle as a queue of turn events ordered by turn number, where
+    // turn 2r is the first army's attack in round r and turn 2r+1 the second's.
+    //
+    // LockStep schedules every turn and is the Demo.cpp loop. Sparse lets an
+    // army sleep while its plan holds: its leader and victim stay put, the
+    // victim stays the closest enemy and every ninja keeps slashing or keeps
+    // walking. Its next turn event is then the predicted kill of the victim or
+    // the first turn a walker may arrive, whichever comes first, and the turns
+    // in between are applied in closed form, stepping only the walkers. The
+    // enemy's turns wake it early when they kill one of its members, move its
+    // victim or bring another member closer to its leader than the victim.
+    //
+    // Living members and their health are counted as fighters die, and
+    // closest members come from a spatial index kept up to date as they
+    // walk, so an event costs the acts of the army that attacks and nothing
+    // in proportion to the army that waits. Both schedules give exactly the
+    // results of Match::attack.
+    class EventEngine {
+        struct Event {
+            long turn;
+            unsigned version;
+
+            bool operator<(const Event &other) const { return turn < other.turn; }
+        };
+
+        struct Side {
+            unsigned version = 0;
+            bool dormant = false;
+            // First own turn not applied yet, and own turns applied asleep.
+            long caughtUp = 0;
+            long slept = 0;
+            int alive = 0;
+            int health = 0;
+            // The plan: the victim and where it stood, the living members it
+            // was made for, and what they do on each turn.
+            int victim = -1;
+            int planned = 0;
+            double victimX = 0;
+            double victimY = 0;
+            int slashers = 0;
+            std::array<int, COWBOY_BULLETS + 1> cowboys{};
+            std::vector<int> walkers;
+        };
+
+        struct View;
+        struct Tracker;
+
+        Schedule schedule;
+        PairingHeap<Event> queue;
+        std::vector<Army> teams;
+        SpatialIndex grid;
+        std::array<Side, 2> sides;
+        double margin = 0;
+        size_t processed = 0;
+
+        void push(int side, long turn);
+        void update(int side, int member, const Fighter &before);
+        long damage(const Side &side, long turns) const;
+        void strike(int side, long turn);
+        void wake(int side, long turn);
+        int turnsToKill(int side, long limit) const;
+        void plan(int side, long turn, long end);
+        bool disturbed(int side) const;
+        Outcome result(int rounds) const;
+        Outcome run(int maxRounds);
+
+    public:
+        explicit EventEngine(Schedule schedule = Schedule::Sparse) : schedule(schedule) {}
+        Outcome play(Battle &battle, int maxRounds = MAX_ROUNDS);
+        size_t events() const { return processed; }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_EVENTENGINE_H
@@ -0,0 +1,241 @@
+//
+// Created by avida on 5/17/2023.
+//
+
+#include "Evolution.hpp"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace ariel {
+
+    static const char *const CHECKPOINT_MAGIC = "cowboy-vs-ninja-evolution-1";
+
+    Roster Genome::toRoster(Ordering ordering) const {
+        Roster roster(ordering);
+        roster.add(genes[(size_t) leader].kind, genes[(size_t) leader].x, genes[(size_t) leader].y);
+        for (int i = 0; i < size; ++i) {
+            if (i != leader) {
+                roster.add(genes[(size_t) i].kind, genes[(size_t) i].x, genes[(size_t) i].y);
+            }
+        }
+        return roster;
+    }
+
+    Evolution::Evolution(const EvolutionConfig &config, std::vector<Roster> opponents)
+            : config(config), opponents(std::move(opponents)), random(config.seed) {
+        if (this->opponents.empty()) {
+            throw std::invalid_argument("evolution needs at least one opponent");
+        }
+        if (config.populationSize < 2 || config.memberCap < 1 || config.memberCap > MAX_MEMBERS ||
+            config.eliteCount < 0 || config.eliteCount > config.populationSize || config.tournamentSize < 1) {
+            throw std::invalid_argument("invalid evolution configuration");
+        }
+        size_t size = (size_t) config.populationSize;
+        population.reserve(size);
+        offspring.reserve(size);
+        scenarios.resize(size * this->opponents.size() * 2);
+        outcomes.resize(scenarios.size());
+        for (size_t i = 0; i < size; ++i) {
+            population.push_back(randomGenome());
+        }
+        champion.fitness = -1;
+    }
+
+    Gene Evolution::randomGene() {
+        std::uniform_int_distribution<int> kind(0, 3);
+        std::uniform_real_distribution<double> x(0, config.width);
+        std::uniform_real_distribution<double> y(0, config.height);
+        return Gene{static_cast<Kind>(kind(random)), x(random), y(random)};
+    }
+
+    Genome Evolution::randomGenome() {
+        Genome genome;
+        genome.size = std::uniform_int_distribution<int>(1, config.memberCap)(random);
+        for (int i = 0; i < genome.size; ++i) {
+            genome.genes[(size_t) i] = randomGene();
+        }
+        genome.leader = std::uniform_int_distribution<int>(0, genome.size - 1)(random);
+        return genome;
+    }
+
+    void Evolution::evaluate() {
+        size_t count = opponents.size();
+        for (size_t i = 0; i < population.size(); ++i) {
+            Roster candidate = population[i].toRoster(config.ordering);
+            for (size_t j = 0; j < count; ++j) {
+                scenarios[(i * count + j) * 2] = Scenario{candidate, opponents[j]};
+                scenarios[(i * count + j) * 2 + 1] = Scenario{opponents[j], candidate};
+            }
+        }
+        Match::playBatch(scenarios, outcomes, config.threads);
+        for (size_t i = 0; i < population.size(); ++i) {
+            double score = 0;
+            for (size_t j = 0; j < count; ++j) {
+                double enemyHealth = opponents[j].totalHealth();
+                const Outcome &first = outcomes[(i * count + j) * 2];
+                const Outcome &second = outcomes[(i * count + j) * 2 + 1];
+                score += first.winner == Winner::First ? 1 : 0;
+                score += second.winner == Winner::Second ? 1 : 0;
+                if (enemyHealth > 0) {
+                    score += 0.25 * (2 - (first.healthSecond + second.healthFirst) / enemyHealth);
+                }
+            }
+            population[i].fitness = score / (double) (2 * count);
+            if (population[i].fitness > champion.fitness) {
+                champion = population[i];
+            }
+        }
+    }
+
+    const Genome &Evolution::select() {
+        std::uniform_int_distribution<size_t> pick(0, population.size() - 1);
+        const Genome *best = &population[pick(random)];
+        for (int i = 1; i < config.tournamentSize; ++i) {
+            const Genome &other = population[pick(random)];
+            if (other.fitness > best->fitness) {
+                best = &other;
+            }
+        }
+        return *best;
+    }
+
+    Genome Evolution::crossover(const Genome &one, const Genome &other) {
+        std::bernoulli_distribution coin(0.5);
+        const Genome &shape = coin(random) ? one : other;
+        Genome child = shape;
+        int common = std::min(one.size, other.size);
+        for (int i = 0; i < common; ++i) {
+            child.genes[(size_t) i] = coin(random) ? one.genes[(size_t) i] : other.genes[(size_t) i];
+        }
+        return child;
+    }
+
+    void Evolution::mutate(Genome &genome) {
+        std::bernoulli_distribution chance(config.mutationRate);
+        std::normal_distribution<double> jitter(0, config.positionSigma);
+        for (int i = 0; i < genome.size; ++i) {
+            Gene &gene = genome.genes[(size_t) i];
+            if (chance(random)) {
+                gene.x = std::clamp(gene.x + jitter(random), 0.0, config.width);
+                gene.y = std::clamp(gene.y + jitter(random), 0.0, config.height);
+            }
+            if (chance(random)) {
+                gene.kind = static_cast<Kind>(std::uniform_int_distribution<int>(0, 3)(random));
+            }
+        }
+        if (chance(random) && genome.size < config.memberCap) {
+            genome.genes[(size_t) genome.size++] = randomGene();
+        }
+        if (chance(random) && genome.size > 1) {
+            int removed = std::uniform_int_distribution<int>(0, genome.size - 1)(random);
+            for (int i = removed; i + 1 < genome.size; ++i) {
+                genome.genes[(size_t) i] = genome.genes[(size_t) i + 1];
+            }
+            genome.size--;
+            if (genome.leader > removed) {
+                genome.leader--;
+            }
+        }
+        if (chance(random) || genome.leader >= genome.size) {
+            genome.leader = std::uniform_int_distribution<int>(0, genome.size - 1)(random);
+        }
+    }
+
+    void Evolution::breed() {
+        std::sort(population.begin(), population.end(),
+                  [](const Genome &one, const Genome &other) { return one.fitness > other.fitness; });
+        offspring.clear();
+        for (int i = 0; i < config.eliteCount; ++i) {
+            offspring.push_back(population[(size_t) i]);
+        }
+        while (offspring.size() < population.size()) {
+            const Genome &one = select();
+            const Genome &other = select();
+            offspring.push_back(crossover(one, other));
+            mutate(offspring.back());
+        }
+        population.swap(offspring);
+    }
+
+    void Evolution::step() {
+        evaluate();
+        breed();
+        generations++;
+    }
+
+    void Evolution::run(int count) {
+        for (int i = 0; i < count; ++i) {
+            step();
+        }
+    }
+
+    static void writeGenome(std::ostream &out, const Genome &genome) {
+        out << genome.size << ' ' << genome.leader << ' ' << genome.fitness;
+        for (int i = 0; i < genome.size; ++i) {
+            const Gene &gene = genome.genes[(size_t) i];
+            out << ' ' << (int) gene.kind << ' ' << gene.x << ' ' << gene.y;
+        }
+        out << '\n';
+    }
+
+    static Genome readGenome(std::istream &in) {
+        Genome genome;
+        in >> genome.size >> genome.leader >> genome.fitness;
+        if (!in || genome.size < 0 || genome.size > MAX_MEMBERS ||
+            (genome.size > 0 && (genome.leader < 0 || genome.leader >= genome.size))) {
+            throw std::runtime_error("corrupt evolution checkpoint");
+        }
+        for (int i = 0; i < genome.size; ++i) {
+            Gene &gene = genome.genes[(size_t) i];
+            int kind = 0;
+            in >> kind >> gene.x >> gene.y;
+            if (!in || kind < 0 || kind > 3) {
+                throw std::runtime_error("corrupt evolution checkpoint");
+            }
+            gene.kind = static_cast<Kind>(kind);
+        }
+        return genome;
+    }
+
+    void Evolution::saveCheckpoint(const std::string &path) const {
+        std::ofstream out(path, std::ios::trunc);
+        out.precision(std::numeric_limits<double>::max_digits10);
+        out << CHECKPOINT_MAGIC << '\n' << generations << ' ' << population.size() << '\n' << random << '\n';
+        writeGenome(out, champion);
+        for (const Genome &genome: population) {
+            writeGenome(out, genome);
+        }
+        if (!out) {
+            throw std::runtime_error("could not write evolution checkpoint " + path);
+        }
+    }
+
+    void Evolution::loadCheckpoint(const std::string &path) {
+        // Read in full before anything is replaced, so a bad file leaves the
+        // evolution as it was.
+        std::ifstream in(path);
+        std::string magic;
+        size_t size = 0;
+        int savedGenerations = 0;
+        std::mt19937_64 savedRandom;
+        in >> magic >> savedGenerations >> size >> savedRandom;
+        if (!in || magic != CHECKPOINT_MAGIC) {
+            throw std::runtime_error("not an evolution checkpoint: " + path);
+        }
+        if (size != population.size()) {
+            throw std::runtime_error("checkpoint population size does not match the configuration");
+        }
+        Genome savedChampion = readGenome(in);
+        std::vector<Genome> saved(size);
+        for (Genome &genome: saved) {
+            genome = readGenome(in);
+        }
+        generations = savedGenerations;
+        random = savedRandom;
+        champion = savedChampion;
+        population = std::move(saved);
+    }
+
+} // ariel
@@ -0,0 +1,82 @@
+//
+// Created by avida on 5/17/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_EVOLUTION_H
+#define COWBOY_VS_NINJA_A_EVOLUTION_H
+
+#include "Match.hpp"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ariel {
+
+    struct Gene {
+        Kind kind;
+        double x;
+        double y;
+    };
+
+    // A candidate team: members in insertion order plus the index of the leader.
+    struct Genome {
+        std::array<Gene, MAX_MEMBERS> genes{};
+        int size = 0;
+        int leader = 0;
+        double fitness = 0;
+
+        Roster toRoster(Ordering ordering) const;
+    };
+
+    struct EvolutionConfig {
+        int populationSize = 64;
+        int memberCap = MAX_MEMBERS;
+        int eliteCount = 2;
+        int tournamentSize = 3;
+        double width = 100;
+        double height = 100;
+        double mutationRate = 0.15;
+        double positionSigma = 5;
+        Ordering ordering = Ordering::CowboysFirst;
+        unsigned threads = 0;
+        std::uint64_t seed = 1;
+    };
+
+    // Genetic search over team compositions and starting points. Every candidate
+    // plays each opponent twice (attacking first and second), and a whole
+    // generation is evaluated with a single Match::playBatch call. The population,
+    // scenario and outcome buffers are allocated once and reused.
+    class Evolution {
+        EvolutionConfig config;
+        std::vector<Roster> opponents;
+        std::vector<Genome> population;
+        std::vector<Genome> offspring;
+        std::vector<Scenario> scenarios;
+        std::vector<Outcome> outcomes;
+        std::mt19937_64 random;
+        Genome champion;
+        int generations = 0;
+
+        Genome randomGenome();
+        Gene randomGene();
+        const Genome &select();
+        void mutate(Genome &genome);
+        Genome crossover(const Genome &one, const Genome &other);
+        void evaluate();
+        void breed();
+
+    public:
+        Evolution(const EvolutionConfig &config, std::vector<Roster> opponents);
+        void step();
+        void run(int count);
+        int generation() const { return generations; }
+        const Genome &best() const { return champion; }
+        const std::vector<Genome> &candidates() const { return population; }
+        void saveCheckpoint(const std::string &path) const;
+        void loadCheckpoint(const std::string &path);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_EVOLUTION_H
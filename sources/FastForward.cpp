@@ -0,0 +1,202 @@
+//
+// Created by avida on 5/19/2023.
+//
+
+#include "FastForward.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace ariel {
+
+    namespace {
+
+        // What one roster does on each of its turns while the span lasts.
+        struct Plan {
+            Roster *own;
+            Roster *enemy;
+            int victim = -1;
+            int slashers = 0;
+            int walkerCount = 0;
+            std::array<int, MAX_MEMBERS> walkers;
+            // Distance from our leader to every living enemy.
+            std::array<double, MAX_MEMBERS> apart;
+            // Distance from every living ninja of ours to the victim.
+            std::array<double, MAX_MEMBERS> reach;
+            // How far each member of ours moves per turn: its speed while it
+            // walks, zero for cowboys and slashers.
+            std::array<double, MAX_MEMBERS> moving{};
+
+            Plan(Roster &own, Roster &enemy) : own(&own), enemy(&enemy) {}
+
+            bool prepare() {
+                const Fighter &leader = own->members[(size_t) own->leader];
+                if (!leader.isAlive()) {
+                    return false;
+                }
+                double best = 0;
+                for (int i = 0; i < enemy->size; ++i) {
+                    const Fighter &member = enemy->members[(size_t) i];
+                    if (!member.isAlive()) {
+                        continue;
+                    }
+                    apart[(size_t) i] = distance(leader.x, leader.y, member.x, member.y);
+                    if (victim < 0 || apart[(size_t) i] < best) {
+                        victim = i;
+                        best = apart[(size_t) i];
+                    }
+                }
+                if (victim < 0) {
+                    return false;
+                }
+                const Fighter &target = enemy->members[(size_t) victim];
+                for (int i = 0; i < own->size; ++i) {
+                    const Fighter &member = own->members[(size_t) i];
+                    if (!member.isAlive() || member.isCowboy()) {
+                        continue;
+                    }
+                    reach[(size_t) i] = distance(member, target);
+                    if (reach[(size_t) i] < SLASH_RANGE) {
+                        slashers++;
+                    } else {
+                        moving[(size_t) i] = speedOf(member.kind);
+                        walkers[(size_t) walkerCount++] = i;
+                    }
+                }
+                return true;
+            }
+
+            // Rounds for which every decision we take is known: the victim stays
+            // the closest enemy to our leader and no ninja of ours switches
+            // between walking and slashing. Everything moves at most its speed
+            // per turn, so each bound is the room left divided by how fast the
+            // two ends can close it. Before our kth turn the enemy has moved at
+            // most k + 1 times, which the bounds assume for both sides. Not
+            // rounded down; the caller does that once.
+            double span(const Plan &enemyPlan, double margin) const {
+                double rounds = HUGE_VAL;
+                double victimSpeed = enemyPlan.moving[(size_t) victim];
+                double leaderSpeed = moving[(size_t) own->leader];
+                for (int i = 0; i < enemy->size; ++i) {
+                    if (i == victim || !enemy->members[(size_t) i].isAlive()) {
+                        continue;
+                    }
+                    double rate = 2 * leaderSpeed + victimSpeed + enemyPlan.moving[(size_t) i];
+                    if (rate > 0) {
+                        rounds = std::min(rounds, (apart[(size_t) i] - apart[(size_t) victim] - margin) / rate);
+                    }
+                }
+                for (int i = 0; i < own->size; ++i) {
+                    const Fighter &member = own->members[(size_t) i];
+                    if (!member.isAlive() || member.isCowboy()) {
+                        continue;
+                    }
+                    double speed = moving[(size_t) i];
+                    if (speed > 0) {
+                        // Still at least SLASH_RANGE away on the last walking turn;
+                        // against a standing victim this is the arrival round
+                        // ceil((reach - SLASH_RANGE) / speed) in closed form.
+                        rounds = std::min(rounds, (reach[(size_t) i] - SLASH_RANGE - margin + speed) / (speed + victimSpeed));
+                    } else if (victimSpeed > 0) {
+                        // A slasher stays in range while the victim walks away.
+                        rounds = std::min(rounds, (SLASH_RANGE - 2 * margin - reach[(size_t) i]) / victimSpeed);
+                    }
+                }
+                return rounds;
+            }
+
+            int damage(int rounds) const {
+                int total = slashers * SLASH_DAMAGE * rounds;
+                for (int i = 0; i < own->size; ++i) {
+                    const Fighter &member = own->members[(size_t) i];
+                    if (member.isAlive() && member.isCowboy()) {
+                        total += BULLET_DAMAGE * FastForward::shots(rounds, member.bullets);
+                    }
+                }
+                return total;
+            }
+
+            void walk() {
+                const Fighter &target = enemy->members[(size_t) victim];
+                for (int i = 0; i < walkerCount; ++i) {
+                    Fighter &ninja = own->members[(size_t) walkers[(size_t) i]];
+                    moveTowards(ninja, target, speedOf(ninja.kind));
+                }
+            }
+
+            void finish(int rounds) {
+                enemy->members[(size_t) victim].health -= damage(rounds);
+                for (int i = 0; i < own->size; ++i) {
+                    Fighter &member = own->members[(size_t) i];
+                    if (member.isAlive() && member.isCowboy()) {
+                        member.bullets = FastForward::bulletsAfter(rounds, member.bullets);
+                    }
+                }
+            }
+        };
+
+        // Slack for rounding: every step of moveTowards and every distance is off
+        // by a few ulps of the largest coordinate, far less than this over
+        // MAX_ROUNDS steps.
+        double margin(const Scenario &scenario) {
+            double largest = 1;
+            for (const Roster *roster: {&scenario.first, &scenario.second}) {
+                for (int i = 0; i < roster->size; ++i) {
+                    const Fighter &member = roster->members[(size_t) i];
+                    largest = std::max({largest, std::abs(member.x), std::abs(member.y)});
+                }
+            }
+            return largest * 1e-9;
+        }
+
+    }
+
+    int FastForward::skip(Scenario &scenario, int limit) {
+        Plan first(scenario.first, scenario.second);
+        Plan second(scenario.second, scenario.first);
+        if (limit < WORTHWHILE || !first.prepare() || !second.prepare()) {
+            return 0;
+        }
+        double slack = margin(scenario);
+        double bound = std::min({(double) limit, first.span(second, slack), second.span(first, slack)});
+        if (bound < WORTHWHILE) {
+            return 0;
+        }
+        int healthFirst = scenario.second.members[(size_t) first.victim].health;
+        int healthSecond = scenario.first.members[(size_t) second.victim].health;
+        int low = 0;
+        auto high = (int) bound;
+        while (low < high) {
+            int middle = low + (high - low + 1) / 2;
+            if (first.damage(middle) < healthFirst && second.damage(middle) < healthSecond) {
+                low = middle;
+            } else {
+                high = middle - 1;
+            }
+        }
+        if (low < WORTHWHILE) {
+            return 0;
+        }
+        for (int round = 0; round < low; ++round) {
+            first.walk();
+            second.walk();
+        }
+        first.finish(low);
+        second.finish(low);
+        return low;
+    }
+
+    int QuietRounds::skip(Scenario &scenario, int rounds, int limit) {
+        if (rounds < next) {
+            return 0;
+        }
+        int skipped = FastForward::skip(scenario, limit);
+        if (skipped == 0) {
+            next = rounds + wait;
+            wait = std::min(wait * 2, MAX_WAIT);
+        } else {
+            wait = 2;
+        }
+        return skipped;
+    }
+
+} // ariel
@@ -0,0 +1,60 @@
+//
+// Created by avida on 5/19/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_FASTFORWARD_H
+#define COWBOY_VS_NINJA_A_FASTFORWARD_H
+
+#include "Match.hpp"
+#include <algorithm>
+
+namespace ariel {
+
+    // Skips whole rounds in which no decision can change: nobody dies, no
+    // leader is re-elected, both victims stay the closest enemy and no ninja
+    // switches between walking and slashing. The length of the span comes in
+    // closed form from the distances at its start and the kill bound from the
+    // cowboys' reload cycle; within it only walking ninjas are stepped, one
+    // moveTowards each per turn, so positions stay bit for bit identical to
+    // playing the rounds with Match::attack.
+    class FastForward {
+    public:
+        // Shorter spans are played normally; finding them costs about a round.
+        static constexpr int WORTHWHILE = 2;
+
+        // Bullets fired and left after a cowboy with bullets in its gun shoots
+        // for rounds rounds, reloading whenever it runs dry.
+        static constexpr int shots(int rounds, int bullets) {
+            if (rounds <= bullets) {
+                return rounds;
+            }
+            int cycle = rounds - bullets - 1;
+            return bullets + cycle / (COWBOY_BULLETS + 1) * COWBOY_BULLETS +
+                   std::min(cycle % (COWBOY_BULLETS + 1), COWBOY_BULLETS);
+        }
+
+        static constexpr int bulletsAfter(int rounds, int bullets) {
+            if (rounds <= bullets) {
+                return bullets - rounds;
+            }
+            return COWBOY_BULLETS - (rounds - bullets - 1) % (COWBOY_BULLETS + 1);
+        }
+
+        // Rounds skipped, at most limit; 0 when fewer than WORTHWHILE are quiet.
+        static int skip(Scenario &scenario, int limit);
+    };
+
+    // Calls FastForward::skip for a match in progress, backing off after
+    // every miss so matches with no quiet spans pay for only a few tries.
+    class QuietRounds {
+        static constexpr int MAX_WAIT = 64;
+        int next = 0;
+        int wait = 2;
+
+    public:
+        int skip(Scenario &scenario, int rounds, int limit);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_FASTFORWARD_H
@@ -0,0 +1,246 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#include "Fuzzer.hpp"
+#include "Arena.hpp"
+#include "EventEngine.hpp"
+#include "ShardedBattle.hpp"
+#include "Zobrist.hpp"
+#include <cmath>
+
+namespace ariel {
+
+    static Roster toRoster(const Army &army) {
+        Roster roster(army.ordering);
+        for (int i = 0; i < army.size; ++i) {
+            roster.members[(size_t) i] = army.members[(size_t) i];
+        }
+        roster.size = army.size;
+        roster.leader = army.leader;
+        return roster;
+    }
+
+    // Appends the hash of the scenario after every attack.
+    struct Hashes : NoObserver {
+        std::vector<std::uint64_t> *hashes;
+
+        void attackFinished(const Scenario &scenario, int /*side*/) { hashes->push_back(Zobrist::hash(scenario)); }
+    };
+
+    // Appends the incrementally kept hash after every attack.
+    struct IncrementalHashes : ZobristObserver {
+        std::vector<std::uint64_t> *hashes;
+
+        IncrementalHashes(const Scenario &scenario, std::vector<std::uint64_t> &hashes)
+                : ZobristObserver(scenario), hashes(&hashes) {}
+        void attackFinished(const Scenario & /*scenario*/, int /*side*/) { hashes->push_back(value()); }
+    };
+
+    static Engine withOptions(const std::string &name, MatchOptions options) {
+        return Engine{name, [options](const Scenario &scenario, int maxRounds, std::vector<std::uint64_t> &) {
+            MatchOptions limited = options;
+            limited.maxRounds = maxRounds;
+            return Match::play(scenario, limited);
+        }, false};
+    }
+
+    std::vector<Engine> Fuzzer::builtinEngines() {
+        std::vector<Engine> engines;
+        engines.push_back(Engine{"Match::attack", [](const Scenario &start, int maxRounds,
+                                                     std::vector<std::uint64_t> &hashes) {
+            Scenario scenario = start;
+            Hashes observer{{}, &hashes};
+            return Match::stepByStep(scenario, observer, maxRounds);
+        }, true});
+        engines.push_back(Engine{"ZobristObserver", [](const Scenario &start, int maxRounds,
+                                                       std::vector<std::uint64_t> &hashes) {
+            Scenario scenario = start;
+            IncrementalHashes observer(scenario, hashes);
+            return Match::stepByStep(scenario, observer, maxRounds);
+        }, true});
+        engines.push_back(Engine{"Arena", [](const Scenario &scenario, int maxRounds,
+                                             std::vector<std::uint64_t> &hashes) {
+            Arena arena({Army(scenario.first), Army(scenario.second)});
+            auto state = [&arena] { return Scenario{toRoster(arena.team(0)), toRoster(arena.team(1))}; };
+            int rounds = 0;
+            while (rounds < maxRounds && arena.standing() > 1) {
+                arena.attack(0);
+                hashes.push_back(Zobrist::hash(state()));
+                arena.attack(1);
+                hashes.push_back(Zobrist::hash(state()));
+                rounds++;
+            }
+            return Match::result(state(), rounds);
+        }, true});
+        engines.push_back(withOptions("Match::play/all", MatchOptions{MAX_ROUNDS, true, true, true}));
+        engines.push_back(withOptions("Match::play/skip", MatchOptions{MAX_ROUNDS, true, false, false}));
+        engines.push_back(withOptions("Match::play/volleys", MatchOptions{MAX_ROUNDS, false, true, false}));
+        engines.push_back(withOptions("Match::play/endgames", MatchOptions{MAX_ROUNDS, false, false, true}));
+        for (Schedule schedule: {Schedule::LockStep, Schedule::Sparse}) {
+            engines.push_back(Engine{schedule == Schedule::LockStep ? "EventEngine/LockStep" : "EventEngine/Sparse",
+                                     [schedule](const Scenario &scenario, int maxRounds, std::vector<std::uint64_t> &) {
+                                         Battle battle(scenario);
+                                         EventEngine engine(schedule);
+                                         return engine.play(battle, maxRounds);
+                                     }, false});
+        }
+        engines.push_back(Engine{"ShardedBattle", [](const Scenario &scenario, int maxRounds,
+                                                     std::vector<std::uint64_t> &) {
+            ShardedBattle battle(Battle(scenario), 2);
+            return battle.play(maxRounds);
+        }, false});
+        return engines;
+    }
+
+    Fuzzer::Fuzzer(std::uint64_t seed, std::vector<Engine> engines, int maxRounds)
+            : random(seed), engines(std::move(engines)), maxRounds(maxRounds) {
+    }
+
+    // Mixes the cases the rules are touchy about: ties on integer grids,
+    // stacked fighters, wounded members and half empty guns.
+    Scenario Fuzzer::generate() {
+        std::uniform_int_distribution<int> kind(0, 3);
+        std::uniform_int_distribution<int> size(1, MAX_MEMBERS);
+        std::uniform_int_distribution<int> percent(0, 99);
+        const std::array<double, 5> spreads{0.5, 3, 20, 80, 300};
+        double spread = spreads[random() % spreads.size()];
+        bool grid = percent(random) < 40;
+        std::uniform_real_distribution<double> coordinate(0, spread);
+        Scenario scenario;
+        for (Roster *roster: {&scenario.first, &scenario.second}) {
+            *roster = Roster(percent(random) < 50 ? Ordering::CowboysFirst : Ordering::Insertion);
+            for (int i = size(random); i > 0; --i) {
+                auto chosen = static_cast<Kind>(kind(random));
+                Fighter fighter{coordinate(random), coordinate(random), startingHealth(chosen),
+                                chosen == Kind::Cowboy ? COWBOY_BULLETS : 0, chosen};
+                if (grid) {
+                    fighter.x = std::round(fighter.x);
+                    fighter.y = std::round(fighter.y);
+                }
+                if (percent(random) < 20) {
+                    fighter.health = 1 + (int) (random() % (std::uint64_t) fighter.health);
+                }
+                if (fighter.isCowboy() && percent(random) < 20) {
+                    fighter.bullets = (int) (random() % (COWBOY_BULLETS + 1));
+                }
+                roster->add(fighter);
+            }
+            roster->leader = (int) (random() % (std::uint64_t) roster->size);
+        }
+        return scenario;
+    }
+
+    static bool sameOutcome(const Outcome &one, const Outcome &other) {
+        return one.winner == other.winner && one.rounds == other.rounds && one.aliveFirst == other.aliveFirst &&
+               one.aliveSecond == other.aliveSecond && one.healthFirst == other.healthFirst &&
+               one.healthSecond == other.healthSecond;
+    }
+
+    std::optional<Discrepancy> Fuzzer::check(const Scenario &scenario, const Engine &engine) const {
+        std::vector<std::uint64_t> expected;
+        Outcome reference = Reference::play(Reference::fromRoster(scenario.first), Reference::fromRoster(scenario.second),
+                                            maxRounds, engine.perTurn ? &expected : nullptr);
+        std::vector<std::uint64_t> hashes;
+        Outcome outcome = engine.play(scenario, maxRounds, hashes);
+        if (engine.perTurn) {
+            for (size_t i = 0; i < std::max(expected.size(), hashes.size()); ++i) {
+                if (i >= expected.size() || i >= hashes.size() || expected[i] != hashes[i]) {
+                    return Discrepancy{engine.name, scenario, (int) i};
+                }
+            }
+        }
+        if (!sameOutcome(outcome, reference)) {
+            return Discrepancy{engine.name, scenario, -1};
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Discrepancy> Fuzzer::check(const Scenario &scenario) const {
+        for (const Engine &engine: engines) {
+            if (auto found = check(scenario, engine)) {
+                return found;
+            }
+        }
+        return std::nullopt;
+    }
+
+    static Roster without(const Roster &roster, int member) {
+        Roster smaller(roster.ordering);
+        for (int i = 0; i < roster.size; ++i) {
+            if (i != member) {
+                smaller.members[(size_t) smaller.size++] = roster.members[(size_t) i];
+            }
+        }
+        smaller.leader = roster.leader == member ? 0 : roster.leader - (member < roster.leader ? 1 : 0);
+        return smaller;
+    }
+
+    // Greedy shrinking: drop members, then simplify the ones left, keeping
+    // any change after which the engine still disagrees with the reference.
+    Scenario Fuzzer::minimize(const Scenario &scenario, const Engine &engine) const {
+        Scenario current = scenario;
+        bool shrunk = true;
+        while (shrunk) {
+            shrunk = false;
+            std::vector<Scenario> candidates;
+            for (int side = 0; side < 2; ++side) {
+                const Roster &roster = side == 0 ? current.first : current.second;
+                for (int member = 0; member < roster.size && roster.size > 1; ++member) {
+                    Scenario candidate = current;
+                    (side == 0 ? candidate.first : candidate.second) = without(roster, member);
+                    candidates.push_back(candidate);
+                }
+            }
+            for (int side = 0; side < 2; ++side) {
+                const Roster &roster = side == 0 ? current.first : current.second;
+                for (int member = 0; member < roster.size; ++member) {
+                    const Fighter &fighter = roster.members[(size_t) member];
+                    Fighter simpler = fighter;
+                    simpler.x = std::round(fighter.x);
+                    simpler.y = std::round(fighter.y);
+                    Fighter fresh = fighter;
+                    fresh.health = startingHealth(fighter.kind);
+                    fresh.bullets = fighter.isCowboy() ? COWBOY_BULLETS : 0;
+                    for (const Fighter &replacement: {simpler, fresh}) {
+                        if (replacement.x == fighter.x && replacement.y == fighter.y &&
+                            replacement.health == fighter.health && replacement.bullets == fighter.bullets) {
+                            continue;
+                        }
+                        Scenario candidate = current;
+                        (side == 0 ? candidate.first : candidate.second).members[(size_t) member] = replacement;
+                        candidates.push_back(candidate);
+                    }
+                }
+                if (roster.leader != 0) {
+                    Scenario candidate = current;
+                    (side == 0 ? candidate.first : candidate.second).leader = 0;
+                    candidates.push_back(candidate);
+                }
+            }
+            for (const Scenario &candidate: candidates) {
+                if (check(candidate, engine)) {
+                    current = candidate;
+                    shrunk = true;
+                    break;
+                }
+            }
+        }
+        return current;
+    }
+
+    std::vector<Discrepancy> Fuzzer::run(int cases) {
+        std::vector<Discrepancy> found;
+        for (int i = 0; i < cases; ++i) {
+            Scenario scenario = generate();
+            for (const Engine &engine: engines) {
+                if (auto discrepancy = check(scenario, engine)) {
+                    Scenario smallest = minimize(scenario, engine);
+                    found.push_back(check(smallest, engine).value_or(*discrepancy));
+                }
+            }
+        }
+        return found;
+    }
+
+} // ariel
@@ -0,0 +1,59 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_FUZZER_H
+#define COWBOY_VS_NINJA_A_FUZZER_H
+
+#include "Reference.hpp"
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ariel {
+
+    // An engine under test. Engines that play attack by attack append the
+    // Zobrist hash of the state after every attack, the others leave the
+    // hashes alone and are only compared by outcome.
+    struct Engine {
+        std::string name;
+        std::function<Outcome(const Scenario &scenario, int maxRounds, std::vector<std::uint64_t> &hashes)> play;
+        bool perTurn = false;
+    };
+
+    struct Discrepancy {
+        std::string engine;
+        Scenario scenario;
+        // First attack whose state differs, or -1 when only the outcome does.
+        int attack;
+    };
+
+    // Differential fuzzer: random scenarios go through the reference and every
+    // engine, and a difference is shrunk to a small scenario that still shows
+    // it before it is reported.
+    class Fuzzer {
+        std::mt19937_64 random;
+        std::vector<Engine> engines;
+        int maxRounds;
+
+    public:
+        explicit Fuzzer(std::uint64_t seed, std::vector<Engine> engines = builtinEngines(), int maxRounds = 3000);
+
+        // Match::attack, the Zobrist observer, the two team arena,
+        // Match::play with each shortcut alone and with all of them together,
+        // both EventEngine schedules and the sharded battle.
+        static std::vector<Engine> builtinEngines();
+
+        Scenario generate();
+        std::optional<Discrepancy> check(const Scenario &scenario) const;
+        std::optional<Discrepancy> check(const Scenario &scenario, const Engine &engine) const;
+        Scenario minimize(const Scenario &scenario, const Engine &engine) const;
+        std::vector<Discrepancy> run(int cases);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_FUZZER_H
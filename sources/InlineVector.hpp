@@ -0,0 +1,60 @@
+//
+// Created by avida on 5/27/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_INLINEVECTOR_H
+#define COWBOY_VS_NINJA_A_INLINEVECTOR_H
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+namespace ariel {
+
+    // A vector whose elements live inside the object, for containers with a
+    // hard cap like a team. Adding past CAPACITY throws instead of growing,
+    // with the owner's message when it gives one.
+    template <class T, size_t CAPACITY>
+    class InlineVector {
+        std::array<T, CAPACITY> items{};
+        size_t count = 0;
+
+    public:
+        static constexpr size_t capacity() { return CAPACITY; }
+        constexpr size_t size() const { return count; }
+        constexpr bool empty() const { return count == 0; }
+        constexpr bool full() const { return count == CAPACITY; }
+
+        constexpr void push_back(const T &item, const char *whenFull = "fixed capacity container is full") {
+            if (full()) {
+                throw std::runtime_error(whenFull);
+            }
+            items[count++] = item;
+        }
+
+        constexpr void clear() { count = 0; }
+
+        constexpr T &operator[](size_t index) { return items[index]; }
+        constexpr const T &operator[](size_t index) const { return items[index]; }
+
+        constexpr T *begin() { return items.data(); }
+        constexpr T *end() { return items.data() + count; }
+        constexpr const T *begin() const { return items.data(); }
+        constexpr const T *end() const { return items.data() + count; }
+
+        // Bit i is set when the predicate holds for element i, so "who is
+        // alive" is one word that popcount and countr_zero can walk.
+        template <class Predicate>
+        constexpr std::uint64_t mask(Predicate predicate) const {
+            static_assert(CAPACITY <= 64, "a mask has one bit per element");
+            std::uint64_t bits = 0;
+            for (size_t i = 0; i < count; ++i) {
+                bits |= predicate(items[i]) ? std::uint64_t{1} << i : 0;
+            }
+            return bits;
+        }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_INLINEVECTOR_H
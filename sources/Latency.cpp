@@ -0,0 +1,241 @@
+//
+// Created by avida on 5/23/2023.
+//
+
+#include "Latency.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ariel {
+
+    size_t LatencyHistogram::bucketOf(std::uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) {
+            return (size_t) value;
+        }
+        if (value >> MAX_BITS != 0) {
+            return BUCKETS - 1;
+        }
+        auto shift = (unsigned) (std::bit_width(value) - 1 - SUB_BITS);
+        return (size_t) (shift * SUB_BUCKETS + (value >> shift));
+    }
+
+    std::uint64_t LatencyHistogram::lowest(size_t bucket) {
+        if (bucket < 2 * SUB_BUCKETS) {
+            return bucket;
+        }
+        std::uint64_t shift = bucket / SUB_BUCKETS - 1;
+        return (bucket - shift * SUB_BUCKETS) << shift;
+    }
+
+    std::uint64_t LatencyHistogram::highest(size_t bucket) {
+        if (bucket < 2 * SUB_BUCKETS) {
+            return bucket;
+        }
+        std::uint64_t shift = bucket / SUB_BUCKETS - 1;
+        return lowest(bucket) + (1ULL << shift) - 1;
+    }
+
+    LatencyHistogram &LatencyHistogram::operator+=(const LatencyHistogram &other) {
+        for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            counts[bucket] += other.counts[bucket];
+        }
+        return *this;
+    }
+
+    std::uint64_t LatencyHistogram::count() const {
+        std::uint64_t total = 0;
+        for (std::uint64_t samples: counts) {
+            total += samples;
+        }
+        return total;
+    }
+
+    std::uint64_t LatencyHistogram::percentile(double fraction) const {
+        std::uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = std::max<std::uint64_t>(1, (std::uint64_t) std::ceil(fraction * (double) total));
+        std::uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            seen += counts[bucket];
+            if (seen >= rank) {
+                return highest(bucket);
+            }
+        }
+        return highest(BUCKETS - 1);
+    }
+
+    std::uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (std::uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Measured once against the steady clock over a few milliseconds.
+    double ticksPerNanosecond() {
+        static const double rate = [] {
+            auto start = std::chrono::steady_clock::now();
+            std::uint64_t first = ticks();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            std::uint64_t last = ticks();
+            auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            return elapsed > 0 && last > first ? (double) (last - first) / elapsed : 1.0;
+        }();
+        return rate;
+    }
+
+    // Only the owning thread writes a buffer, so relaxed loads and stores are
+    // enough; readers may see a sample or two late but never a torn count.
+    struct LatencyRecorder::Buffer {
+        static constexpr size_t HISTOGRAMS = (size_t) STAGES * (MAX_MEMBERS + 1) * 2;
+
+        std::array<std::array<std::atomic<std::uint64_t>, LatencyHistogram::BUCKETS>, HISTOGRAMS> counts{};
+        Buffer *next = nullptr;
+        // Set while a thread records into the buffer.
+        std::atomic<bool> owned{true};
+
+        static size_t slot(int stage, int size, Ordering ordering) {
+            return ((size_t) stage * (MAX_MEMBERS + 1) + (size_t) size) * 2 + (size_t) ordering;
+        }
+    };
+
+    LatencyRecorder::~LatencyRecorder() {
+        Buffer *buffer = buffers.load();
+        while (buffer != nullptr) {
+            Buffer *next = buffer->next;
+            delete buffer;
+            buffer = next;
+        }
+    }
+
+    LatencyRecorder &LatencyRecorder::instance() {
+        static LatencyRecorder recorder;
+        return recorder;
+    }
+
+    // Buffers outlive their threads, so samples of finished workers still
+    // show up in the report. A thread that exits hands its buffer back, and
+    // the next new thread records on top of it, so the list only grows to
+    // the most threads that ever recorded at once.
+    LatencyRecorder::Buffer &LatencyRecorder::local() {
+        struct Owner {
+            Buffer *buffer = nullptr;
+
+            ~Owner() {
+                if (buffer != nullptr) {
+                    buffer->owned.store(false, std::memory_order_release);
+                }
+            }
+        };
+        thread_local Owner owner;
+        if (owner.buffer != nullptr) {
+            return *owner.buffer;
+        }
+        for (Buffer *buffer = buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+            bool owned = false;
+            if (buffer->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+                owner.buffer = buffer;
+                return *buffer;
+            }
+        }
+        auto *buffer = new Buffer();
+        buffer->next = buffers.load(std::memory_order_relaxed);
+        while (!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+        }
+        owner.buffer = buffer;
+        return *buffer;
+    }
+
+    void LatencyRecorder::record(int stage, int size, Ordering ordering, std::uint64_t elapsed) {
+        std::atomic<std::uint64_t> &count =
+                local().counts[Buffer::slot(stage, std::clamp(size, 0, MAX_MEMBERS), ordering)]
+                [LatencyHistogram::bucketOf(elapsed)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram LatencyRecorder::merged(int stage, int size, Ordering ordering) const {
+        LatencyHistogram histogram;
+        size_t slot = Buffer::slot(stage, size, ordering);
+        for (Buffer *buffer = buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+            for (size_t bucket = 0; bucket < LatencyHistogram::BUCKETS; ++bucket) {
+                histogram.add(bucket, buffer->counts[slot][bucket].load(std::memory_order_relaxed));
+            }
+        }
+        return histogram;
+    }
+
+    std::vector<LatencyRow> LatencyRecorder::report() const {
+        std::vector<LatencyRow> rows;
+        double rate = ticksPerNanosecond();
+        for (int stage = 0; stage < STAGES; ++stage) {
+            for (int size = 0; size <= MAX_MEMBERS; ++size) {
+                for (Ordering ordering: {Ordering::CowboysFirst, Ordering::Insertion}) {
+                    LatencyHistogram histogram = merged(stage, size, ordering);
+                    std::uint64_t count = histogram.count();
+                    if (count == 0) {
+                        continue;
+                    }
+                    rows.push_back(LatencyRow{stage, size, ordering, count,
+                                              (double) histogram.percentile(0.5) / rate,
+                                              (double) histogram.percentile(0.9) / rate,
+                                              (double) histogram.percentile(0.99) / rate,
+                                              (double) histogram.percentile(0.999) / rate});
+                }
+            }
+        }
+        return rows;
+    }
+
+    std::string LatencyRecorder::format() const {
+        std::ostringstream out;
+        out << "stage size ordering count p50-ns p90-ns p99-ns p999-ns\n";
+        for (const LatencyRow &row: report()) {
+            out << (row.stage == TURN_STAGE ? "turn" : phaseName((Phase) row.stage)) << ' ' << row.size << ' '
+                << (row.ordering == Ordering::CowboysFirst ? "Team" : "Team2") << ' ' << row.count << ' '
+                << row.p50 << ' ' << row.p90 << ' ' << row.p99 << ' ' << row.p999 << '\n';
+        }
+        return out.str();
+    }
+
+    size_t LatencyRecorder::bufferCount() const {
+        size_t count = 0;
+        for (Buffer *buffer = buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+            count++;
+        }
+        return count;
+    }
+
+    void LatencyRecorder::clear() {
+        for (Buffer *buffer = buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+            for (auto &histogram: buffer->counts) {
+                for (auto &count: histogram) {
+                    count.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    void LatencyObserver::attackStarting(const Scenario &scenario, int side) {
+        const Roster &attackers = side == 0 ? scenario.first : scenario.second;
+        size = attackers.size;
+        ordering = attackers.ordering;
+        attackStarted = ticks();
+    }
+
+    void LatencyObserver::attackFinished(const Scenario & /*scenario*/, int /*side*/) {
+        LatencyRecorder::instance().record(TURN_STAGE, size, ordering, ticks() - attackStarted);
+    }
+
+} // ariel
@@ -0,0 +1,109 @@
+//
+// Created by avida on 5/23/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_LATENCY_H
+#define COWBOY_VS_NINJA_A_LATENCY_H
+
+#include "Match.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ariel {
+
+    // Log-linear histogram of tick counts in the style of HdrHistogram: exact
+    // below 2 * SUB_BUCKETS, then SUB_BUCKETS buckets per power of two, which
+    // keeps every percentile within about 3% of the true value. Values of
+    // 2^MAX_BITS ticks and more share the last bucket.
+    class LatencyHistogram {
+    public:
+        static constexpr int SUB_BITS = 5;
+        static constexpr int MAX_BITS = 44;
+        static constexpr std::uint64_t SUB_BUCKETS = 1U << SUB_BITS;
+        static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+        static size_t bucketOf(std::uint64_t value);
+        static std::uint64_t lowest(size_t bucket);
+        static std::uint64_t highest(size_t bucket);
+
+        void record(std::uint64_t value) { counts[bucketOf(value)]++; }
+        void add(size_t bucket, std::uint64_t count) { counts[bucket] += count; }
+        LatencyHistogram &operator+=(const LatencyHistogram &other);
+        std::uint64_t count() const;
+        // Upper edge of the bucket holding the given fraction of the samples.
+        std::uint64_t percentile(double fraction) const;
+
+    private:
+        std::array<std::uint64_t, BUCKETS> counts{};
+    };
+
+    // Time stamp counter where there is one, steady clock nanoseconds
+    // elsewhere.
+    std::uint64_t ticks();
+    double ticksPerNanosecond();
+
+    // The phases of Match::attack and, as the last stage, the whole attack.
+    constexpr int STAGES = PHASES + 1;
+    constexpr int TURN_STAGE = PHASES;
+
+    struct LatencyRow {
+        int stage;
+        int size;
+        Ordering ordering;
+        std::uint64_t count;
+        double p50;
+        double p90;
+        double p99;
+        double p999;
+    };
+
+    // Collects latencies from any number of threads. Each thread records into
+    // its own buffer of histograms, pushed once onto a lock-free list, and
+    // report() sums the buffers while the owners keep recording.
+    class LatencyRecorder {
+        struct Buffer;
+
+        std::atomic<Buffer *> buffers{nullptr};
+
+        LatencyRecorder() = default;
+        Buffer &local();
+
+    public:
+        LatencyRecorder(const LatencyRecorder &) = delete;
+        LatencyRecorder &operator=(const LatencyRecorder &) = delete;
+        ~LatencyRecorder();
+
+        static LatencyRecorder &instance();
+        void record(int stage, int size, Ordering ordering, std::uint64_t elapsed);
+        LatencyHistogram merged(int stage, int size, Ordering ordering) const;
+        // Rows with samples, percentiles in nanoseconds.
+        std::vector<LatencyRow> report() const;
+        std::string format() const;
+        // Buffers ever created; threads that exit hand theirs on.
+        size_t bufferCount() const;
+        // Zeroes every buffer; samples recorded meanwhile may be lost.
+        void clear();
+    };
+
+    // Match::stepByStep observer that times each phase and each whole attack
+    // for the attacking team's size and ordering.
+    class LatencyObserver : public NoObserver {
+        int size = 0;
+        Ordering ordering = Ordering::CowboysFirst;
+        std::uint64_t started = 0;
+        std::uint64_t attackStarted = 0;
+
+    public:
+        void enter(Phase /*phase*/) { started = ticks(); }
+        void leave(Phase phase) {
+            LatencyRecorder::instance().record((int) phase, size, ordering, ticks() - started);
+        }
+        void attackStarting(const Scenario &scenario, int side);
+        void attackFinished(const Scenario &scenario, int side);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_LATENCY_H
@@ -0,0 +1,16 @@
+//
+// Created by avida on 5/27/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_LIMITS_H
+#define COWBOY_VS_NINJA_A_LIMITS_H
+
+namespace ariel {
+
+    // The team size cap of the rules, shared by Team and the flat Roster.
+    constexpr int MAX_MEMBERS = 10;
+    constexpr const char *TEAM_FULL = "a team can not have more than ten members";
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_LIMITS_H
@@ -0,0 +1,43 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#include "MappedFile.hpp"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ariel {
+
+    MappedFile::MappedFile(const std::string &path) {
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            throw std::runtime_error("could not open " + path);
+        }
+        struct stat status{};
+        if (::fstat(descriptor, &status) != 0) {
+            ::close(descriptor);
+            throw std::runtime_error("could not read " + path);
+        }
+        length = (size_t) status.st_size;
+        if (length > 0) {
+            void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(descriptor);
+                throw std::runtime_error("could not map " + path);
+            }
+            ::madvise(mapped, length, MADV_SEQUENTIAL);
+            mapping = static_cast<const char *>(mapped);
+        }
+        ::close(descriptor);
+    }
+
+    MappedFile::~MappedFile() {
+        if (mapping != nullptr) {
+            ::munmap(const_cast<char *>(mapping), length);
+        }
+    }
+
+} // ariel
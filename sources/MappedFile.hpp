@@ -0,0 +1,30 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_MAPPEDFILE_H
+#define COWBOY_VS_NINJA_A_MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+
+namespace ariel {
+
+    // A whole file mapped read-only, unmapped again on destruction. Empty
+    // files map to an empty view.
+    class MappedFile {
+        const char *mapping = nullptr;
+        size_t length = 0;
+
+    public:
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        std::string_view bytes() const { return {mapping, length}; }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_MAPPEDFILE_H
@@ -0,0 +1,114 @@
+//
+// Created by avida on 5/17/2023.
+//
+
+#include "Match.hpp"
+#include "Endgame.hpp"
+#include "FastForward.hpp"
+#include "Volley.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ariel {
+
+    const char *phaseName(Phase phase) {
+        switch (phase) {
+            case Phase::Leader: return "leader";
+            case Phase::Victim: return "victim";
+            case Phase::Shoot: return "shoot";
+            case Phase::Slash: return "slash";
+            case Phase::Move: return "move";
+        }
+        return "unknown";
+    }
+
+    Outcome Match::play(Scenario scenario, const MatchOptions &options) {
+        return playInPlace(scenario, options);
+    }
+
+    Outcome Match::playInPlace(Scenario &scenario, const MatchOptions &options) {
+        int rounds = 0;
+        QuietRounds quiet;
+        bool endgames = options.resolveEndgames;
+        while (rounds < options.maxRounds) {
+            int aliveFirst = scenario.first.stillAlive();
+            int aliveSecond = scenario.second.stillAlive();
+            if (aliveFirst == 0 || aliveSecond == 0) {
+                break;
+            }
+            if (endgames && aliveFirst == 1 && aliveSecond == 1) {
+                Outcome outcome{};
+                if (Endgame::instance().resolve(scenario, rounds, options.maxRounds, outcome)) {
+                    return outcome;
+                }
+                // Nobody comes back, so a one on one that resolve turned down
+                // would be turned down every round after.
+                endgames = false;
+            }
+            if (options.skipQuietRounds) {
+                rounds += quiet.skip(scenario, rounds, options.maxRounds - rounds);
+                if (rounds == options.maxRounds) {
+                    break;
+                }
+            }
+            if (options.resolveVolleys) {
+                Volley::attack(scenario.first, scenario.second);
+                Volley::attack(scenario.second, scenario.first);
+            } else {
+                attack(scenario.first, scenario.second);
+                attack(scenario.second, scenario.first);
+            }
+            rounds++;
+        }
+        return result(scenario, rounds);
+    }
+
+    // Splits [0, count) into one contiguous chunk per thread, the calling
+    // thread taking the first.
+    template <class Play>
+    static void inChunks(size_t count, unsigned threads, Play play) {
+        if (threads == 0) {
+            threads = std::max(1U, std::thread::hardware_concurrency());
+        }
+        size_t workers = std::min<size_t>(threads, count);
+        auto run = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                play(i);
+            }
+        };
+        if (workers <= 1) {
+            run(0, count);
+            return;
+        }
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        size_t chunk = (count + workers - 1) / workers;
+        for (size_t w = 1; w < workers; ++w) {
+            pool.emplace_back(run, std::min(w * chunk, count), std::min((w + 1) * chunk, count));
+        }
+        run(0, std::min(chunk, count));
+        for (auto &worker: pool) {
+            worker.join();
+        }
+    }
+
+    void Match::playBatch(std::span<const Scenario> scenarios, std::span<Outcome> outcomes, unsigned threads,
+                          const MatchOptions &options) {
+        if (outcomes.size() < scenarios.size()) {
+            throw std::invalid_argument("outcome buffer is smaller than the batch");
+        }
+        inChunks(scenarios.size(), threads, [&](size_t i) { outcomes[i] = play(scenarios[i], options); });
+    }
+
+    void Match::playBatchInPlace(std::span<Scenario> scenarios, std::span<Outcome> outcomes, unsigned threads,
+                                 const MatchOptions &options) {
+        if (outcomes.size() < scenarios.size()) {
+            throw std::invalid_argument("outcome buffer is smaller than the batch");
+        }
+        inChunks(scenarios.size(), threads, [&](size_t i) { outcomes[i] = playInPlace(scenarios[i], options); });
+    }
+
+} // ariel
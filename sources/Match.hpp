@@ -0,0 +1,446 @@
+//
+// Created by avida on 5/17/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_MATCH_H
+#define COWBOY_VS_NINJA_A_MATCH_H
+
+#include "Limits.hpp"
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace ariel {
+
+    // Flat, allocation free version of the game rules. A Roster keeps its members
+    // in the traversal order of Team (cowboys first) or Team2 (insertion order),
+    // so attack() only ever walks the array front to back. The rules are all
+    // constexpr, so small matches can be played by the compiler; see Tables.hpp.
+
+    enum class Kind : unsigned char { Cowboy, YoungNinja, TrainedNinja, OldNinja };
+    enum class Ordering : unsigned char { CowboysFirst, Insertion };
+    enum class Winner : unsigned char { First, Second, Undecided };
+
+    constexpr int MAX_ROUNDS = 100000;
+    constexpr int COWBOY_HEALTH = 110;
+    constexpr int COWBOY_BULLETS = 6;
+    constexpr int BULLET_DAMAGE = 10;
+    constexpr int SLASH_DAMAGE = 40;
+    constexpr double SLASH_RANGE = 1;
+
+    constexpr int startingHealth(Kind kind) {
+        switch (kind) {
+            case Kind::Cowboy: return COWBOY_HEALTH;
+            case Kind::YoungNinja: return 100;
+            case Kind::TrainedNinja: return 120;
+            case Kind::OldNinja: return 150;
+        }
+        throw std::invalid_argument("unknown character kind");
+    }
+
+    constexpr double speedOf(Kind kind) {
+        switch (kind) {
+            case Kind::Cowboy: return 0;
+            case Kind::YoungNinja: return 14;
+            case Kind::TrainedNinja: return 12;
+            case Kind::OldNinja: return 8;
+        }
+        throw std::invalid_argument("unknown character kind");
+    }
+
+    // value * value as an unevaluated sum of two doubles (Dekker's product).
+    constexpr void exactSquare(double value, double &high, double &low) {
+        double scaled = 134217729.0 * value;
+        double top = scaled - (scaled - value);
+        double bottom = value - top;
+        high = value * value;
+        low = ((top * top - high) + 2 * top * bottom) + bottom * bottom;
+    }
+
+    // std::sqrt, which is not constexpr before C++26. Constant evaluation
+    // refines Newton's method to the correctly rounded root, which is what
+    // std::sqrt returns, so the compiler plays exactly the same match as the
+    // program does.
+    constexpr double squareRoot(double value) {
+        if (!std::is_constant_evaluated()) {
+            return std::sqrt(value);
+        }
+        if (value != value || value < 0) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        if (value == 0 || value == std::numeric_limits<double>::infinity()) {
+            return value;
+        }
+        double scale = 1;
+        while (value < 0x1p-900) {
+            value *= 0x1p200;
+            scale *= 0x1p-100;
+        }
+        auto bits = std::bit_cast<std::uint64_t>(value);
+        double root = std::bit_cast<double>((bits >> 1) + 0x1FF8000000000000ULL);
+        for (int i = 0; i < 6; ++i) {
+            root = 0.5 * (root + value / root);
+        }
+        double best = root;
+        double error = -1;
+        for (std::int64_t step = -2; step <= 2; ++step) {
+            double candidate = std::bit_cast<double>(std::bit_cast<std::uint64_t>(root) + (std::uint64_t) step);
+            double high = 0;
+            double low = 0;
+            exactSquare(candidate, high, low);
+            double miss = (value - high) - low;
+            miss = miss < 0 ? -miss : miss;
+            if (error < 0 || miss < error) {
+                best = candidate;
+                error = miss;
+            }
+        }
+        return best * scale;
+    }
+
+    struct Fighter {
+        double x;
+        double y;
+        int health;
+        int bullets;
+        Kind kind;
+
+        constexpr bool isAlive() const { return health > 0; }
+        constexpr bool isCowboy() const { return kind == Kind::Cowboy; }
+        // A fresh or wounded fighter the rules can start a match with.
+        constexpr bool isValid() const;
+    };
+
+    struct Roster {
+        std::array<Fighter, MAX_MEMBERS> members{};
+        int size = 0;
+        int leader = 0;
+        Ordering ordering = Ordering::CowboysFirst;
+
+        constexpr Roster() = default;
+        constexpr explicit Roster(Ordering ordering) : ordering(ordering) {}
+        // Both return the slot the new member took.
+        constexpr int add(Kind kind, double x, double y);
+        constexpr int add(const Fighter &fighter);
+        constexpr int stillAlive() const;
+        constexpr int totalHealth() const;
+        constexpr int closestAlive(double x, double y) const;
+        // Checks every field, for rosters that come from outside the library.
+        constexpr bool isValid() const;
+    };
+
+    struct Scenario {
+        Roster first;
+        Roster second;
+    };
+
+    struct Outcome {
+        Winner winner;
+        int rounds;
+        int aliveFirst;
+        int aliveSecond;
+        int healthFirst;
+        int healthSecond;
+    };
+
+    struct MatchOptions {
+        int maxRounds = MAX_ROUNDS;
+        bool skipQuietRounds = false;
+        bool resolveVolleys = false;
+        bool resolveEndgames = true;
+    };
+
+    constexpr double distance(double x1, double y1, double x2, double y2) {
+        double dx = x2 - x1;
+        double dy = y2 - y1;
+        return squareRoot(dx * dx + dy * dy);
+    }
+
+    constexpr double distance(const Fighter &one, const Fighter &other) {
+        return distance(one.x, one.y, other.x, other.y);
+    }
+
+    constexpr void moveTowards(Fighter &mover, const Fighter &target, double step) {
+        double length = distance(mover, target);
+        if (length <= step) {
+            mover.x = target.x;
+            mover.y = target.y;
+            return;
+        }
+        double ratio = step / length;
+        mover.x += (target.x - mover.x) * ratio;
+        mover.y += (target.y - mover.y) * ratio;
+    }
+
+    constexpr int Roster::add(Kind kind, double x, double y) {
+        return add(Fighter{x, y, startingHealth(kind), kind == Kind::Cowboy ? COWBOY_BULLETS : 0, kind});
+    }
+
+    constexpr int Roster::add(const Fighter &fighter) {
+        if (size == MAX_MEMBERS) {
+            throw std::runtime_error(TEAM_FULL);
+        }
+        int position = size;
+        if (ordering == Ordering::CowboysFirst && fighter.isCowboy()) {
+            position = 0;
+            while (position < size && members[(size_t) position].isCowboy()) {
+                position++;
+            }
+        }
+        for (int i = size; i > position; --i) {
+            members[(size_t) i] = members[(size_t) i - 1];
+        }
+        members[(size_t) position] = fighter;
+        if (size > 0 && position <= leader) {
+            leader++;
+        }
+        size++;
+        return position;
+    }
+
+    constexpr int Roster::stillAlive() const {
+        int alive = 0;
+        for (int i = 0; i < size; ++i) {
+            alive += members[(size_t) i].isAlive() ? 1 : 0;
+        }
+        return alive;
+    }
+
+    constexpr int Roster::totalHealth() const {
+        int health = 0;
+        for (int i = 0; i < size; ++i) {
+            health += members[(size_t) i].health > 0 ? members[(size_t) i].health : 0;
+        }
+        return health;
+    }
+
+    constexpr int Roster::closestAlive(double x, double y) const {
+        int closest = -1;
+        double best = 0;
+        for (int i = 0; i < size; ++i) {
+            const Fighter &member = members[(size_t) i];
+            if (!member.isAlive()) {
+                continue;
+            }
+            double length = distance(x, y, member.x, member.y);
+            if (closest < 0 || length < best) {
+                closest = i;
+                best = length;
+            }
+        }
+        return closest;
+    }
+
+    // NaN and the infinities are the only values x - x is not zero for.
+    constexpr bool isFinite(double value) { return value - value == 0; }
+
+    constexpr bool Fighter::isValid() const {
+        return kind <= Kind::OldNinja && health > 0 && health <= startingHealth(kind) && bullets >= 0 &&
+               bullets <= COWBOY_BULLETS && isFinite(x) && isFinite(y);
+    }
+
+    constexpr bool Roster::isValid() const {
+        if (size < 1 || size > MAX_MEMBERS || leader < 0 || leader >= size || ordering > Ordering::Insertion) {
+            return false;
+        }
+        for (int i = 0; i < size; ++i) {
+            if (!members[(size_t) i].isValid()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Hooks called by Match::attack around every state change. Observers pass
+    // the roster and member index before and after the change; the defaults
+    // are empty and inline away. Match::stepByStep also calls the round and
+    // attack hooks, side 0 being the first team. Observers derive from this
+    // and hide only the hooks they need.
+    struct NoObserver {
+        template <class Side> constexpr void changing(const Side & /*side*/, int /*member*/) {}
+        template <class Side> constexpr void changed(const Side & /*side*/, int /*member*/) {}
+        template <class Side> constexpr void leaderChanging(const Side & /*side*/) {}
+        template <class Side> constexpr void leaderChanged(const Side & /*side*/) {}
+        constexpr void roundStarting(const Scenario & /*scenario*/, int /*round*/) {}
+        constexpr void roundFinished(const Scenario & /*scenario*/, int /*round*/) {}
+        constexpr void attackStarting(const Scenario & /*scenario*/, int /*side*/) {}
+        constexpr void attackFinished(const Scenario & /*scenario*/, int /*side*/) {}
+    };
+
+    // Phases of an attack. Observers that also define enter(Phase) and
+    // leave(Phase) get called around each of them; for all others the calls
+    // and the extra range check are compiled out.
+    enum class Phase : unsigned char { Leader, Victim, Shoot, Slash, Move };
+    constexpr int PHASES = 5;
+
+    const char *phaseName(Phase phase);
+
+    template <class Observer>
+    concept PhaseObserver = requires(Observer &observer) {
+        observer.enter(Phase::Leader);
+        observer.leave(Phase::Leader);
+    };
+
+    // Observers that also define pickVictim(defenders) choose the first
+    // victim of the attack themselves; a negative answer keeps the rule's
+    // choice. Later victims always follow the rule.
+    template <class Observer, class Side>
+    concept VictimPicker = requires(Observer &observer, const Side &defenders) {
+        { observer.pickVictim(defenders) } -> std::convertible_to<int>;
+    };
+
+    class Match {
+    public:
+        static constexpr void act(Fighter &attacker, Fighter &victim);
+        static constexpr void attack(Roster &attackers, Roster &defenders);
+        template <class Side, class Observer>
+        static constexpr void attack(Side &attackers, Side &defenders, Observer &observer);
+        // Plays every attack with attack() and no shortcuts, also at compile
+        // time. The observer version leaves the final rosters in scenario.
+        static constexpr Outcome stepByStep(Scenario scenario, int maxRounds = MAX_ROUNDS);
+        template <class Observer>
+        static constexpr Outcome stepByStep(Scenario &scenario, Observer &observer, int maxRounds = MAX_ROUNDS);
+        static Outcome play(Scenario scenario, const MatchOptions &options = {});
+        // Leaves the final rosters in scenario. A resolved endgame stops the
+        // rosters at the start of the duel, with one fighter on each side.
+        static Outcome playInPlace(Scenario &scenario, const MatchOptions &options = {});
+        static constexpr Outcome result(const Scenario &scenario, int rounds);
+        static void playBatch(std::span<const Scenario> scenarios, std::span<Outcome> outcomes,
+                              unsigned threads = 0, const MatchOptions &options = {});
+        static void playBatchInPlace(std::span<Scenario> scenarios, std::span<Outcome> outcomes,
+                                     unsigned threads = 0, const MatchOptions &options = {});
+    };
+
+    // Side is a Roster or any roster-like type with the same members, size,
+    // leader, stillAlive() and closestAlive().
+    template <class Side, class Observer>
+    constexpr void Match::attack(Side &attackers, Side &defenders, Observer &observer) {
+        if (attackers.stillAlive() == 0 || defenders.stillAlive() == 0) {
+            return;
+        }
+        const Fighter &former = attackers.members[(size_t) attackers.leader];
+        if (!former.isAlive()) {
+            if constexpr (PhaseObserver<Observer>) {
+                observer.enter(Phase::Leader);
+            }
+            observer.leaderChanging(attackers);
+            attackers.leader = attackers.closestAlive(former.x, former.y);
+            observer.leaderChanged(attackers);
+            if constexpr (PhaseObserver<Observer>) {
+                observer.leave(Phase::Leader);
+            }
+        }
+        const Fighter &leader = attackers.members[(size_t) attackers.leader];
+        if constexpr (PhaseObserver<Observer>) {
+            observer.enter(Phase::Victim);
+        }
+        int victim = -1;
+        if constexpr (VictimPicker<Observer, Side>) {
+            victim = observer.pickVictim(defenders);
+        }
+        if (victim < 0) {
+            victim = defenders.closestAlive(leader.x, leader.y);
+        }
+        if constexpr (PhaseObserver<Observer>) {
+            observer.leave(Phase::Victim);
+        }
+        for (int i = 0; i < attackers.size; ++i) {
+            Fighter &attacker = attackers.members[(size_t) i];
+            if (!attacker.isAlive()) {
+                continue;
+            }
+            if (!defenders.members[(size_t) victim].isAlive()) {
+                if constexpr (PhaseObserver<Observer>) {
+                    observer.enter(Phase::Victim);
+                }
+                victim = defenders.closestAlive(leader.x, leader.y);
+                if constexpr (PhaseObserver<Observer>) {
+                    observer.leave(Phase::Victim);
+                }
+                if (victim < 0) {
+                    return;
+                }
+            }
+            Fighter &target = defenders.members[(size_t) victim];
+            [[maybe_unused]] Phase phase = Phase::Shoot;
+            if constexpr (PhaseObserver<Observer>) {
+                if (!attacker.isCowboy()) {
+                    phase = distance(attacker, target) < SLASH_RANGE ? Phase::Slash : Phase::Move;
+                }
+                observer.enter(phase);
+            }
+            observer.changing(attackers, i);
+            observer.changing(defenders, victim);
+            act(attacker, target);
+            observer.changed(attackers, i);
+            observer.changed(defenders, victim);
+            if constexpr (PhaseObserver<Observer>) {
+                observer.leave(phase);
+            }
+        }
+    }
+
+    constexpr void Match::act(Fighter &attacker, Fighter &victim) {
+        if (attacker.isCowboy()) {
+            if (attacker.bullets > 0) {
+                victim.health -= BULLET_DAMAGE;
+                attacker.bullets--;
+            } else {
+                attacker.bullets = COWBOY_BULLETS;
+            }
+        } else if (distance(attacker, victim) < SLASH_RANGE) {
+            victim.health -= SLASH_DAMAGE;
+        } else {
+            moveTowards(attacker, victim, speedOf(attacker.kind));
+        }
+    }
+
+    constexpr void Match::attack(Roster &attackers, Roster &defenders) {
+        NoObserver observer;
+        attack(attackers, defenders, observer);
+    }
+
+    constexpr Outcome Match::result(const Scenario &scenario, int rounds) {
+        int aliveFirst = scenario.first.stillAlive();
+        int aliveSecond = scenario.second.stillAlive();
+        Winner winner = Winner::Undecided;
+        if (aliveSecond == 0 && aliveFirst > 0) {
+            winner = Winner::First;
+        } else if (aliveFirst == 0 && aliveSecond > 0) {
+            winner = Winner::Second;
+        }
+        return Outcome{winner, rounds, aliveFirst, aliveSecond,
+                       scenario.first.totalHealth(), scenario.second.totalHealth()};
+    }
+
+    constexpr Outcome Match::stepByStep(Scenario scenario, int maxRounds) {
+        NoObserver observer;
+        return stepByStep(scenario, observer, maxRounds);
+    }
+
+    template <class Observer>
+    constexpr Outcome Match::stepByStep(Scenario &scenario, Observer &observer, int maxRounds) {
+        int rounds = 0;
+        while (rounds < maxRounds && scenario.first.stillAlive() > 0 && scenario.second.stillAlive() > 0) {
+            observer.roundStarting(scenario, rounds);
+            observer.attackStarting(scenario, 0);
+            attack(scenario.first, scenario.second, observer);
+            observer.attackFinished(scenario, 0);
+            observer.attackStarting(scenario, 1);
+            attack(scenario.second, scenario.first, observer);
+            observer.attackFinished(scenario, 1);
+            observer.roundFinished(scenario, rounds);
+            rounds++;
+        }
+        return result(scenario, rounds);
+    }
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_MATCH_H
@@ -0,0 +1,206 @@
+//
+// Created by avida on 5/18/2023.
+//
+
+#include "OutcomeCache.hpp"
+#include <algorithm>
+#include <bit>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace ariel {
+
+    static const std::uint64_t CACHE_MAGIC = 0x4e4a4143484531ULL;
+
+    struct OutcomeCache::Header {
+        std::uint64_t magic;
+        std::uint64_t capacity;
+        std::uint64_t count;
+    };
+
+    struct OutcomeCache::Slot {
+        ScenarioKey key;
+        Outcome outcome;
+    };
+
+    static std::uint64_t mix(std::uint64_t hash, std::uint64_t word) {
+        hash ^= word + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        hash ^= hash >> 30;
+        hash *= 0xbf58476d1ce4e5b9ULL;
+        hash ^= hash >> 27;
+        hash *= 0x94d049bb133111ebULL;
+        return hash ^ (hash >> 31);
+    }
+
+    static std::uint64_t hashRoster(std::uint64_t hash, const Roster &roster) {
+        hash = mix(hash, (std::uint64_t) roster.size);
+        hash = mix(hash, (std::uint64_t) roster.leader);
+        hash = mix(hash, (std::uint64_t) roster.ordering);
+        for (int i = 0; i < roster.size; ++i) {
+            const Fighter &member = roster.members[(size_t) i];
+            hash = mix(hash, (std::uint64_t) member.kind);
+            hash = mix(hash, (std::uint64_t) (std::uint32_t) member.health);
+            hash = mix(hash, (std::uint64_t) (std::uint32_t) member.bullets);
+            hash = mix(hash, std::bit_cast<std::uint64_t>(member.x));
+            hash = mix(hash, std::bit_cast<std::uint64_t>(member.y));
+        }
+        return hash;
+    }
+
+    OutcomeCache::OutcomeCache(const std::string &path, size_t capacity) {
+        descriptor = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (descriptor < 0) {
+            throw std::runtime_error("could not open outcome cache " + path);
+        }
+        struct stat status{};
+        if (::fstat(descriptor, &status) != 0) {
+            ::close(descriptor);
+            throw std::runtime_error("could not read the size of outcome cache " + path);
+        }
+        size_t slotCount = std::bit_ceil(std::max<size_t>(capacity, 16));
+        bool fresh = status.st_size == 0;
+        if (fresh) {
+            length = sizeof(Header) + slotCount * sizeof(Slot);
+            if (::ftruncate(descriptor, (off_t) length) != 0) {
+                ::close(descriptor);
+                throw std::runtime_error("could not size outcome cache " + path);
+            }
+        } else if ((size_t) status.st_size < sizeof(Header)) {
+            ::close(descriptor);
+            throw std::runtime_error("not an outcome cache: " + path);
+        } else {
+            length = (size_t) status.st_size;
+        }
+        mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(descriptor);
+            throw std::runtime_error("could not map outcome cache " + path);
+        }
+        header = static_cast<Header *>(mapping);
+        slots = reinterpret_cast<Slot *>(static_cast<char *>(mapping) + sizeof(Header));
+        if (fresh) {
+            *header = Header{CACHE_MAGIC, slotCount, 0};
+        } else if (header->magic != CACHE_MAGIC || !std::has_single_bit(header->capacity) ||
+                   header->capacity != (length - sizeof(Header)) / sizeof(Slot) ||
+                   length != sizeof(Header) + header->capacity * sizeof(Slot)) {
+            ::munmap(mapping, length);
+            ::close(descriptor);
+            throw std::runtime_error("not an outcome cache: " + path);
+        }
+    }
+
+    OutcomeCache::~OutcomeCache() {
+        ::munmap(mapping, length);
+        ::close(descriptor);
+    }
+
+    Scenario OutcomeCache::canonical(const Scenario &scenario) {
+        double minX = 0;
+        double minY = 0;
+        bool any = false;
+        for (const Roster *roster: {&scenario.first, &scenario.second}) {
+            for (int i = 0; i < roster->size; ++i) {
+                const Fighter &member = roster->members[(size_t) i];
+                minX = any ? std::min(minX, member.x) : member.x;
+                minY = any ? std::min(minY, member.y) : member.y;
+                any = true;
+            }
+        }
+        Scenario shifted = scenario;
+        for (Roster *roster: {&shifted.first, &shifted.second}) {
+            for (int i = 0; i < roster->size; ++i) {
+                roster->members[(size_t) i].x -= minX;
+                roster->members[(size_t) i].y -= minY;
+            }
+        }
+        return shifted;
+    }
+
+    ScenarioKey OutcomeCache::key(const Scenario &scenario) {
+        Scenario shifted = canonical(scenario);
+        std::uint64_t hash = hashRoster(hashRoster(1, shifted.first), shifted.second);
+        std::uint64_t check = hashRoster(hashRoster(2, shifted.second), shifted.first);
+        return ScenarioKey{hash, check | 1};
+    }
+
+    const OutcomeCache::Slot *OutcomeCache::locate(const ScenarioKey &key) const {
+        std::uint64_t mask = header->capacity - 1;
+        for (std::uint64_t index = key.hash & mask;; index = (index + 1) & mask) {
+            const Slot &slot = slots[index];
+            if (slot.key.check == 0 || slot.key == key) {
+                return &slot;
+            }
+        }
+    }
+
+    bool OutcomeCache::find(const ScenarioKey &key, Outcome &outcome) const {
+        const Slot *slot = locate(key);
+        if (slot->key.check == 0) {
+            return false;
+        }
+        outcome = slot->outcome;
+        return true;
+    }
+
+    bool OutcomeCache::insert(const ScenarioKey &key, const Outcome &outcome) {
+        auto *slot = const_cast<Slot *>(locate(key));
+        if (slot->key.check == 0) {
+            if ((header->count + 1) * 4 > header->capacity * 3) {
+                return false;
+            }
+            header->count++;
+        }
+        slot->outcome = outcome;
+        slot->key = key;
+        return true;
+    }
+
+    Outcome OutcomeCache::play(const Scenario &scenario) {
+        ScenarioKey scenarioKey = key(scenario);
+        Outcome outcome{};
+        if (!find(scenarioKey, outcome)) {
+            outcome = Match::play(canonical(scenario));
+            insert(scenarioKey, outcome);
+        }
+        return outcome;
+    }
+
+    void OutcomeCache::playBatch(std::span<const Scenario> scenarios, std::span<Outcome> outcomes, unsigned threads) {
+        if (outcomes.size() < scenarios.size()) {
+            throw std::invalid_argument("outcome buffer is smaller than the batch");
+        }
+        std::vector<ScenarioKey> keys(scenarios.size());
+        std::vector<size_t> missed;
+        std::vector<Scenario> pending;
+        for (size_t i = 0; i < scenarios.size(); ++i) {
+            keys[i] = key(scenarios[i]);
+            if (!find(keys[i], outcomes[i])) {
+                missed.push_back(i);
+                pending.push_back(canonical(scenarios[i]));
+            }
+        }
+        std::vector<Outcome> played(pending.size());
+        Match::playBatch(pending, played, threads);
+        for (size_t i = 0; i < missed.size(); ++i) {
+            outcomes[missed[i]] = played[i];
+            insert(keys[missed[i]], played[i]);
+        }
+    }
+
+    size_t OutcomeCache::size() const {
+        return header->count;
+    }
+
+    size_t OutcomeCache::capacity() const {
+        return header->capacity;
+    }
+
+    void OutcomeCache::flush() {
+        ::msync(mapping, length, MS_SYNC);
+    }
+
+} // ariel
@@ -0,0 +1,63 @@
+//
+// Created by avida on 5/18/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_OUTCOMECACHE_H
+#define COWBOY_VS_NINJA_A_OUTCOMECACHE_H
+
+#include "Match.hpp"
+#include <cstdint>
+#include <string>
+
+namespace ariel {
+
+    struct ScenarioKey {
+        std::uint64_t hash;
+        std::uint64_t check;
+
+        bool operator==(const ScenarioKey &other) const = default;
+    };
+
+    // Content addressed store of match outcomes in a memory mapped file. The
+    // table uses open addressing with linear probing and a power of two number
+    // of slots; the file is native endian and sized once when it is created.
+    // Scenarios are keyed by their canonical form, which is shifted so the
+    // smallest coordinates of all members are zero. The rules only look at
+    // distances, so a shifted copy of a formation shares the entry, but only
+    // when the shift is undone exactly: integer shifts of integer coordinates
+    // do, while a copy moved by 0.1 usually rounds to a different key and
+    // misses. A miss plays the canonical scenario itself, which keeps every
+    // stored outcome exact for its key.
+    class OutcomeCache {
+        struct Header;
+        struct Slot;
+
+        int descriptor = -1;
+        void *mapping = nullptr;
+        size_t length = 0;
+        Header *header = nullptr;
+        Slot *slots = nullptr;
+
+        const Slot *locate(const ScenarioKey &key) const;
+
+    public:
+        OutcomeCache(const std::string &path, size_t capacity);
+        OutcomeCache(const OutcomeCache &) = delete;
+        OutcomeCache &operator=(const OutcomeCache &) = delete;
+        ~OutcomeCache();
+
+        static Scenario canonical(const Scenario &scenario);
+        static ScenarioKey key(const Scenario &scenario);
+
+        bool find(const ScenarioKey &key, Outcome &outcome) const;
+        bool insert(const ScenarioKey &key, const Outcome &outcome);
+        Outcome play(const Scenario &scenario);
+        void playBatch(std::span<const Scenario> scenarios, std::span<Outcome> outcomes, unsigned threads = 0);
+        size_t size() const;
+        size_t capacity() const;
+        void flush();
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_OUTCOMECACHE_H
@@ -0,0 +1,106 @@
+//
+// Created by avida on 5/21/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_PAIRINGHEAP_H
+#define COWBOY_VS_NINJA_A_PAIRINGHEAP_H
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace ariel {
+
+    // Min pairing heap over a pool of nodes. Popped nodes go back to a free
+    // list, so a long simulation allocates only while the heap grows.
+    template <class T, class Less = std::less<T>>
+    class PairingHeap {
+        static constexpr int NONE = -1;
+
+        struct Node {
+            T value;
+            int child;
+            int sibling;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<int> spare;
+        std::vector<int> pairs;
+        int root = NONE;
+        size_t count = 0;
+        Less less;
+
+        int meld(int one, int other) {
+            if (one == NONE) {
+                return other;
+            }
+            if (other == NONE) {
+                return one;
+            }
+            if (less(nodes[(size_t) other].value, nodes[(size_t) one].value)) {
+                std::swap(one, other);
+            }
+            nodes[(size_t) other].sibling = nodes[(size_t) one].child;
+            nodes[(size_t) one].child = other;
+            return one;
+        }
+
+    public:
+        bool empty() const { return count == 0; }
+        size_t size() const { return count; }
+
+        const T &top() const {
+            if (root == NONE) {
+                throw std::out_of_range("top of an empty heap");
+            }
+            return nodes[(size_t) root].value;
+        }
+
+        void push(const T &value) {
+            int node = 0;
+            if (spare.empty()) {
+                node = (int) nodes.size();
+                nodes.push_back(Node{value, NONE, NONE});
+            } else {
+                node = spare.back();
+                spare.pop_back();
+                nodes[(size_t) node] = Node{value, NONE, NONE};
+            }
+            root = meld(root, node);
+            count++;
+        }
+
+        T pop() {
+            T value = top();
+            int child = nodes[(size_t) root].child;
+            spare.push_back(root);
+            pairs.clear();
+            while (child != NONE) {
+                int next = nodes[(size_t) child].sibling;
+                int after = next == NONE ? NONE : nodes[(size_t) next].sibling;
+                if (next != NONE) {
+                    nodes[(size_t) next].sibling = NONE;
+                }
+                nodes[(size_t) child].sibling = NONE;
+                pairs.push_back(meld(child, next));
+                child = after;
+            }
+            root = NONE;
+            for (auto pair = pairs.rbegin(); pair != pairs.rend(); ++pair) {
+                root = meld(root, *pair);
+            }
+            count--;
+            return value;
+        }
+
+        void clear() {
+            nodes.clear();
+            spare.clear();
+            root = NONE;
+            count = 0;
+        }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_PAIRINGHEAP_H
@@ -0,0 +1,108 @@
+//
+// Created by avida on 5/23/2023.
+//
+
+#include "PerfCounters.hpp"
+#include <linux/perf_event.h>
+#include <sstream>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace ariel {
+
+    CounterValues &CounterValues::operator+=(const CounterValues &other) {
+        cycles += other.cycles;
+        instructions += other.instructions;
+        l1Misses += other.l1Misses;
+        llcMisses += other.llcMisses;
+        branchMisses += other.branchMisses;
+        return *this;
+    }
+
+    CounterValues CounterValues::operator-(const CounterValues &other) const {
+        return CounterValues{cycles - other.cycles, instructions - other.instructions, l1Misses - other.l1Misses,
+                             llcMisses - other.llcMisses, branchMisses - other.branchMisses};
+    }
+
+    static int openEvent(std::uint32_t type, std::uint64_t config, int group) {
+        perf_event_attr attributes{};
+        attributes.size = sizeof(attributes);
+        attributes.type = type;
+        attributes.config = config;
+        attributes.disabled = group < 0 ? 1U : 0U;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_GROUP;
+        return (int) ::syscall(SYS_perf_event_open, &attributes, 0, -1, group, 0);
+    }
+
+    PerfCounters::PerfCounters() {
+        const std::array<std::pair<std::uint32_t, std::uint64_t>, EVENTS> events{{
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        }};
+        for (size_t i = 0; i < events.size(); ++i) {
+            descriptors[i] = openEvent(events[i].first, events[i].second, group);
+            if (descriptors[i] < 0) {
+                for (int &descriptor: descriptors) {
+                    if (descriptor >= 0) {
+                        ::close(descriptor);
+                    }
+                    descriptor = -1;
+                }
+                group = -1;
+                return;
+            }
+            if (i == 0) {
+                group = descriptors[0];
+            }
+        }
+        ::ioctl(group, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(group, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    PerfCounters::~PerfCounters() {
+        for (int descriptor: descriptors) {
+            if (descriptor >= 0) {
+                ::close(descriptor);
+            }
+        }
+    }
+
+    CounterValues PerfCounters::read() const {
+        if (group < 0) {
+            return {};
+        }
+        std::array<std::uint64_t, EVENTS + 1> values{};
+        if (::read(group, values.data(), sizeof(values)) != (ssize_t) sizeof(values)) {
+            return {};
+        }
+        return CounterValues{values[1], values[2], values[3], values[4], values[5]};
+    }
+
+    PhaseCounters &PhaseCounters::operator+=(const PhaseCounters &other) {
+        for (size_t phase = 0; phase < PHASES; ++phase) {
+            totals[phase] += other.totals[phase];
+            entries[phase] += other.entries[phase];
+        }
+        return *this;
+    }
+
+    std::string PhaseCounters::report() const {
+        std::ostringstream out;
+        out << "phase entries cycles instructions l1-misses llc-misses branch-misses\n";
+        for (size_t phase = 0; phase < PHASES; ++phase) {
+            const CounterValues &values = totals[phase];
+            out << phaseName((Phase) phase) << ' ' << entries[phase] << ' ' << values.cycles << ' '
+                << values.instructions << ' ' << values.l1Misses << ' ' << values.llcMisses << ' '
+                << values.branchMisses << '\n';
+        }
+        return out.str();
+    }
+
+} // ariel
@@ -0,0 +1,70 @@
+//
+// Created by avida on 5/23/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_PERFCOUNTERS_H
+#define COWBOY_VS_NINJA_A_PERFCOUNTERS_H
+
+#include "Match.hpp"
+#include <cstdint>
+#include <string>
+
+namespace ariel {
+
+    struct CounterValues {
+        std::uint64_t cycles = 0;
+        std::uint64_t instructions = 0;
+        std::uint64_t l1Misses = 0;
+        std::uint64_t llcMisses = 0;
+        std::uint64_t branchMisses = 0;
+
+        CounterValues &operator+=(const CounterValues &other);
+        CounterValues operator-(const CounterValues &other) const;
+    };
+
+    // One perf_event_open group of hardware counters for the calling thread,
+    // read with a single system call. Kernels or containers that refuse the
+    // events leave it unavailable and every read returns zeros.
+    class PerfCounters {
+        static constexpr int EVENTS = 5;
+
+        int group = -1;
+        std::array<int, EVENTS> descriptors{-1, -1, -1, -1, -1};
+
+    public:
+        PerfCounters();
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+        ~PerfCounters();
+
+        bool available() const { return group >= 0; }
+        CounterValues read() const;
+    };
+
+    // Match::attack observer that charges the counter deltas to each phase.
+    // Totals of several matches or threads add up with +=. Play matches with
+    // Match::stepByStep; the fast paths of Match::play have no phases to
+    // charge.
+    class PhaseCounters : public NoObserver {
+        const PerfCounters *counters;
+        CounterValues started;
+        std::array<CounterValues, PHASES> totals{};
+        std::array<std::uint64_t, PHASES> entries{};
+
+    public:
+        explicit PhaseCounters(const PerfCounters &counters) : counters(&counters) {}
+
+        void enter(Phase /*phase*/) { started = counters->read(); }
+        void leave(Phase phase) {
+            totals[(size_t) phase] += counters->read() - started;
+            entries[(size_t) phase]++;
+        }
+        PhaseCounters &operator+=(const PhaseCounters &other);
+        const CounterValues &operator[](Phase phase) const { return totals[(size_t) phase]; }
+        std::uint64_t count(Phase phase) const { return entries[(size_t) phase]; }
+        std::string report() const;
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_PERFCOUNTERS_H
@@ -0,0 +1,349 @@
+//
+// Created by avida on 5/23/2023.
+//
+
+#include "ProcessBatch.hpp"
+#include "Endgame.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <csignal>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace ariel {
+
+    static constexpr std::uint64_t RING_SIZE = 1024;
+    static constexpr std::uint64_t RING_MASK = RING_SIZE - 1;
+    static constexpr long COORDINATOR_POLL_NS = 200000;
+    static constexpr long WORKER_POLL_NS = 50000;
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared counters must not need a lock");
+
+    namespace {
+
+        struct Range {
+            std::uint32_t begin;
+            std::uint32_t end;
+        };
+
+        // Bounded MPMC ring with a sequence number per cell (Vyukov). Every
+        // field is address free, so processes can share it through a mapping.
+        // A worker can be killed anywhere, so pop() first marks the cell as
+        // taken by its owner, hands the range over and only then frees the
+        // cell; the coordinator reclaims cells a dead worker still holds, and
+        // the others step the head past them.
+        struct Ring {
+            static constexpr std::uint64_t TAKEN = std::uint64_t{1} << 63;
+
+            struct Cell {
+                std::atomic<std::uint64_t> sequence;
+                Range range;
+            };
+
+            alignas(64) std::atomic<std::uint64_t> tail;
+            alignas(64) std::atomic<std::uint64_t> head;
+            alignas(64) std::atomic<std::uint32_t> shutdown;
+            Cell cells[RING_SIZE];
+
+            Ring() : tail(0), head(0), shutdown(0), cells{} {
+                for (std::uint64_t i = 0; i < RING_SIZE; ++i) {
+                    cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            bool push(Range range) {
+                std::uint64_t position = tail.load(std::memory_order_relaxed);
+                while (true) {
+                    Cell &cell = cells[position & RING_MASK];
+                    std::uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    if ((sequence & TAKEN) != 0) {
+                        // Still held from the lap before; full until reclaimed.
+                        return false;
+                    }
+                    auto difference = (std::int64_t) (sequence - position);
+                    if (difference == 0) {
+                        if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            cell.range = range;
+                            cell.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (difference < 0) {
+                        return false;
+                    } else {
+                        position = tail.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Takes the range at the head for owner and passes it to take()
+            // before the cell can be reused.
+            template <class Take>
+            bool pop(std::uint64_t owner, Take take) {
+                std::uint64_t position = head.load(std::memory_order_acquire);
+                while (true) {
+                    Cell &cell = cells[position & RING_MASK];
+                    std::uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    if (sequence == position + 1) {
+                        if (cell.sequence.compare_exchange_strong(sequence, TAKEN | owner, std::memory_order_acq_rel)) {
+                            std::uint64_t expected = position;
+                            head.compare_exchange_strong(expected, position + 1, std::memory_order_release);
+                            take(cell.range);
+                            cell.sequence.store(position + RING_SIZE, std::memory_order_release);
+                            return true;
+                        }
+                    } else if ((sequence & TAKEN) != 0 ? tail.load(std::memory_order_acquire) > position
+                                                       : (std::int64_t) (sequence - (position + 1)) > 0) {
+                        // Taken at this position, and perhaps even reclaimed and
+                        // refilled, by an owner that died before moving the head
+                        // on. A cell still taken from the lap before keeps the
+                        // tail from passing it, so with the tail past us the
+                        // taking happened on this lap.
+                        if (head.compare_exchange_strong(position, position + 1, std::memory_order_acq_rel)) {
+                            position++;
+                        }
+                    } else {
+                        return false;
+                    }
+                }
+            }
+
+            // Frees the cell a dead owner was taking, if any, and returns its
+            // range. Only the pushing side may call it: nothing is pushed into
+            // a taken cell, so the tail is less than a lap past it.
+            bool reclaim(std::uint64_t owner, Range &range) {
+                for (std::uint64_t i = 0; i < RING_SIZE; ++i) {
+                    Cell &cell = cells[i];
+                    if (cell.sequence.load(std::memory_order_acquire) == (TAKEN | owner)) {
+                        std::uint64_t last = tail.load(std::memory_order_relaxed) - 1;
+                        range = cell.range;
+                        cell.sequence.store(last - ((last - i) & RING_MASK) + RING_SIZE, std::memory_order_release);
+                        return true;
+                    }
+                }
+                return false;
+            }
+        };
+
+        // What a worker is doing: the next scenario of its range and the end
+        // of the range packed in one word, and when it started on that
+        // scenario. The two change together under a sequence number that is
+        // odd while the worker writes, so the watchdog never pairs the start
+        // time of one scenario with another.
+        struct WorkerSlot {
+            alignas(64) std::atomic<std::uint64_t> sequence;
+            std::atomic<std::uint64_t> progress;
+            std::atomic<std::int64_t> since;
+
+            void publish(std::uint64_t next, std::int64_t started) {
+                std::uint64_t first = sequence.load(std::memory_order_relaxed);
+                sequence.store(first + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                since.store(started, std::memory_order_relaxed);
+                progress.store(next, std::memory_order_release);
+                sequence.store(first + 2, std::memory_order_release);
+            }
+
+            // False while the worker is in the middle of an update; a worker
+            // killed there is reaped before it is asked again.
+            bool read(std::uint64_t &next, std::int64_t &started) const {
+                std::uint64_t first = sequence.load(std::memory_order_acquire);
+                next = progress.load(std::memory_order_relaxed);
+                started = since.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return (first & 1) == 0 && sequence.load(std::memory_order_relaxed) == first;
+            }
+        };
+
+        std::uint64_t pack(std::uint32_t next, std::uint32_t end) { return (std::uint64_t) next << 32 | end; }
+
+        std::int64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void pause(long nanoseconds) {
+            timespec delay{0, nanoseconds};
+            ::nanosleep(&delay, nullptr);
+        }
+
+        class SharedMapping {
+            void *mapping = MAP_FAILED;
+            size_t length;
+
+        public:
+            explicit SharedMapping(size_t length) : length(length) {
+                mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+                if (mapping == MAP_FAILED) {
+                    throw std::runtime_error("could not map shared batch memory");
+                }
+            }
+
+            SharedMapping(const SharedMapping &) = delete;
+            SharedMapping &operator=(const SharedMapping &) = delete;
+            ~SharedMapping() { ::munmap(mapping, length); }
+
+            char *data() const { return static_cast<char *>(mapping); }
+        };
+
+        [[noreturn]] void work(Ring &ring, unsigned owner, WorkerSlot &slot, std::span<const Scenario> scenarios,
+                               Outcome *outcomes, const MatchOptions &options) {
+            try {
+                Range range{};
+                while (true) {
+                    // The range is published while the cell still holds it, so
+                    // wherever we die the coordinator finds it in one or the other.
+                    bool taken = ring.pop(owner, [&](Range claimed) {
+                        range = claimed;
+                        slot.publish(pack(claimed.begin, claimed.end), now());
+                    });
+                    if (!taken) {
+                        if (ring.shutdown.load(std::memory_order_acquire) != 0) {
+                            ::_exit(0);
+                        }
+                        pause(WORKER_POLL_NS);
+                        continue;
+                    }
+                    for (std::uint32_t job = range.begin; job < range.end; ++job) {
+                        if (job != range.begin) {
+                            slot.publish(pack(job, range.end), now());
+                        }
+                        outcomes[job] = Match::play(scenarios[job], options);
+                    }
+                    slot.publish(pack(range.end, range.end), now());
+                }
+            } catch (...) {
+                ::_exit(1);
+            }
+        }
+
+    } // namespace
+
+    size_t ProcessBatch::play(std::span<const Scenario> scenarios, std::span<Outcome> outcomes,
+                              const ProcessOptions &process, const MatchOptions &options) {
+        if (outcomes.size() < scenarios.size()) {
+            throw std::invalid_argument("outcome buffer is smaller than the batch");
+        }
+        if (scenarios.size() > UINT32_MAX) {
+            throw std::invalid_argument("batch is too large for one coordinator");
+        }
+        if (scenarios.empty()) {
+            return 0;
+        }
+        unsigned workers = process.workers != 0 ? process.workers : std::max(1U, std::thread::hardware_concurrency());
+        workers = (unsigned) std::min<size_t>(workers, scenarios.size());
+        size_t chunk = process.chunk != 0 ? process.chunk : std::max<size_t>(1, scenarios.size() / (16 * workers));
+
+        size_t slotsOffset = sizeof(Ring);
+        size_t outcomesOffset = slotsOffset + workers * sizeof(WorkerSlot);
+        SharedMapping shared(outcomesOffset + scenarios.size() * sizeof(Outcome));
+        Ring &ring = *new(shared.data()) Ring();
+        auto *slots = reinterpret_cast<WorkerSlot *>(shared.data() + slotsOffset);
+        for (unsigned w = 0; w < workers; ++w) {
+            new(&slots[w]) WorkerSlot{};
+        }
+        auto *results = reinterpret_cast<Outcome *>(shared.data() + outcomesOffset);
+
+        std::vector<pid_t> pids(workers, -1);
+        // Anything built on first use is built here, so no child inherits a
+        // static initializer another thread was in the middle of.
+        Endgame::instance();
+        auto spawn = [&](unsigned worker) {
+            slots[worker].sequence.store(0, std::memory_order_relaxed);
+            slots[worker].progress.store(0, std::memory_order_relaxed);
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                work(ring, worker, slots[worker], scenarios, results, options);
+            }
+            if (pid < 0) {
+                for (pid_t started: pids) {
+                    if (started > 0) {
+                        ::kill(started, SIGKILL);
+                        ::waitpid(started, nullptr, 0);
+                    }
+                }
+                throw std::runtime_error("could not fork a batch worker");
+            }
+            pids[worker] = pid;
+        };
+        for (unsigned w = 0; w < workers; ++w) {
+            spawn(w);
+        }
+
+        size_t pushed = 0;
+        size_t failed = 0;
+        std::vector<Range> orphans;
+        unsigned running = workers;
+        while (running > 0) {
+            while (!orphans.empty() && ring.push(orphans.back())) {
+                orphans.pop_back();
+            }
+            while (pushed < scenarios.size()) {
+                size_t end = std::min(scenarios.size(), pushed + chunk);
+                if (!ring.push(Range{(std::uint32_t) pushed, (std::uint32_t) end})) {
+                    break;
+                }
+                pushed = end;
+            }
+            if (pushed == scenarios.size() && orphans.empty()) {
+                ring.shutdown.store(1, std::memory_order_release);
+            }
+
+            for (unsigned worker = 0; worker < workers; ++worker) {
+                int status = 0;
+                if (pids[worker] < 0 || ::waitpid(pids[worker], &status, WNOHANG) != pids[worker]) {
+                    continue;
+                }
+                pids[worker] = -1;
+                std::uint64_t progress = slots[worker].progress.load(std::memory_order_acquire);
+                auto next = (std::uint32_t) (progress >> 32);
+                auto end = (std::uint32_t) progress;
+                Range held{};
+                if (ring.reclaim(worker, held) && progress != pack(held.begin, held.end)) {
+                    // Killed inside pop(), before the range reached the slot.
+                    orphans.push_back(held);
+                    ring.shutdown.store(0, std::memory_order_release);
+                }
+                if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && next == end) {
+                    running--;
+                    continue;
+                }
+                if (next < end) {
+                    results[next] = Outcome{Winner::Undecided, FAILED_ROUNDS, 0, 0, 0, 0};
+                    failed++;
+                    if (next + 1 < end) {
+                        orphans.push_back(Range{next + 1, end});
+                        ring.shutdown.store(0, std::memory_order_release);
+                    }
+                }
+                while (!orphans.empty() && ring.push(orphans.back())) {
+                    orphans.pop_back();
+                }
+                spawn(worker);
+            }
+
+            if (process.timeout.count() > 0) {
+                std::int64_t limit = now() - process.timeout.count();
+                for (unsigned w = 0; w < workers; ++w) {
+                    std::uint64_t progress = 0;
+                    std::int64_t since = 0;
+                    if (pids[w] > 0 && slots[w].read(progress, since) &&
+                        (progress >> 32) < (std::uint32_t) progress && since < limit) {
+                        ::kill(pids[w], SIGKILL);
+                    }
+                }
+            }
+            if (running > 0) {
+                pause(COORDINATOR_POLL_NS);
+            }
+        }
+        std::copy(results, results + scenarios.size(), outcomes.begin());
+        return failed;
+    }
+
+} // ariel
@@ -0,0 +1,42 @@
+//
+// Created by avida on 5/23/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_PROCESSBATCH_H
+#define COWBOY_VS_NINJA_A_PROCESSBATCH_H
+
+#include "Match.hpp"
+#include <chrono>
+
+namespace ariel {
+
+    struct ProcessOptions {
+        // Worker processes; 0 uses one per hardware thread.
+        unsigned workers = 0;
+        // Scenarios handed out at a time; 0 gives each worker about sixteen
+        // chunks.
+        size_t chunk = 0;
+        // Wall time one scenario may take before its worker is killed; zero
+        // waits forever.
+        std::chrono::nanoseconds timeout{0};
+    };
+
+    // Plays a batch in forked worker processes, so a crashing or runaway match
+    // only costs its own scenario. Workers read the scenarios from the memory
+    // they inherit, take ranges of them from a lock-free ring in a shared
+    // mapping and write outcomes straight into that mapping. The coordinator
+    // only refills the ring, watches the clock and replaces dead workers; the
+    // rest of a dead worker's range goes back into the ring.
+    class ProcessBatch {
+    public:
+        static constexpr int FAILED_ROUNDS = -1;
+
+        // Returns how many scenarios failed. Their outcomes are undecided
+        // with FAILED_ROUNDS rounds.
+        static size_t play(std::span<const Scenario> scenarios, std::span<Outcome> outcomes,
+                           const ProcessOptions &process = {}, const MatchOptions &options = {});
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_PROCESSBATCH_H
@@ -0,0 +1,148 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#include "Reference.hpp"
+#include "Zobrist.hpp"
+#include <cmath>
+
+namespace ariel {
+
+    static std::vector<int> traversal(const Reference::Side &side) {
+        std::vector<int> order;
+        for (int i = 0; i < (int) side.members.size(); ++i) {
+            if (side.ordering == Ordering::Insertion || side.members[(size_t) i].isCowboy()) {
+                order.push_back(i);
+            }
+        }
+        if (side.ordering == Ordering::CowboysFirst) {
+            for (int i = 0; i < (int) side.members.size(); ++i) {
+                if (!side.members[(size_t) i].isCowboy()) {
+                    order.push_back(i);
+                }
+            }
+        }
+        return order;
+    }
+
+    static int alive(const Reference::Side &side) {
+        int count = 0;
+        for (const Fighter &member: side.members) {
+            if (member.health > 0) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    static double length(double x1, double y1, double x2, double y2) {
+        return std::sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+    }
+
+    // Closest living member; on a tie the one checked first wins.
+    static int closest(const Reference::Side &side, double x, double y) {
+        int found = -1;
+        for (int i: traversal(side)) {
+            const Fighter &member = side.members[(size_t) i];
+            if (member.health <= 0) {
+                continue;
+            }
+            if (found < 0 || length(x, y, member.x, member.y) <
+                             length(x, y, side.members[(size_t) found].x, side.members[(size_t) found].y)) {
+                found = i;
+            }
+        }
+        return found;
+    }
+
+    Reference::Side Reference::fromRoster(const Roster &roster) {
+        Side side;
+        side.members.assign(roster.members.begin(), roster.members.begin() + roster.size);
+        side.leader = roster.leader;
+        side.ordering = roster.ordering;
+        return side;
+    }
+
+    // Traversal order is the order Roster stores its members in.
+    Scenario Reference::toScenario(const Side &first, const Side &second) {
+        Scenario scenario;
+        Roster *rosters[] = {&scenario.first, &scenario.second};
+        const Side *sides[] = {&first, &second};
+        for (int s = 0; s < 2; ++s) {
+            *rosters[s] = Roster(sides[s]->ordering);
+            for (int i: traversal(*sides[s])) {
+                if (i == sides[s]->leader) {
+                    rosters[s]->leader = rosters[s]->size;
+                }
+                rosters[s]->members[(size_t) rosters[s]->size++] = sides[s]->members[(size_t) i];
+            }
+        }
+        return scenario;
+    }
+
+    void Reference::attack(Side &attackers, Side &defenders) {
+        if (alive(attackers) == 0 || alive(defenders) == 0) {
+            return;
+        }
+        if (attackers.members[(size_t) attackers.leader].health <= 0) {
+            const Fighter &dead = attackers.members[(size_t) attackers.leader];
+            attackers.leader = closest(attackers, dead.x, dead.y);
+        }
+        int victim = -1;
+        for (int i: traversal(attackers)) {
+            Fighter &attacker = attackers.members[(size_t) i];
+            if (attacker.health <= 0) {
+                continue;
+            }
+            if (victim < 0 || defenders.members[(size_t) victim].health <= 0) {
+                const Fighter &leader = attackers.members[(size_t) attackers.leader];
+                victim = closest(defenders, leader.x, leader.y);
+                if (victim < 0) {
+                    return;
+                }
+            }
+            Fighter &target = defenders.members[(size_t) victim];
+            if (attacker.kind == Kind::Cowboy) {
+                if (attacker.bullets > 0) {
+                    target.health -= 10;
+                    attacker.bullets--;
+                } else {
+                    attacker.bullets = 6;
+                }
+                continue;
+            }
+            double apart = length(attacker.x, attacker.y, target.x, target.y);
+            if (apart < 1) {
+                target.health -= 40;
+                continue;
+            }
+            double speed = attacker.kind == Kind::YoungNinja ? 14 : attacker.kind == Kind::TrainedNinja ? 12 : 8;
+            if (apart <= speed) {
+                attacker.x = target.x;
+                attacker.y = target.y;
+            } else {
+                double ratio = speed / apart;
+                attacker.x += (target.x - attacker.x) * ratio;
+                attacker.y += (target.y - attacker.y) * ratio;
+            }
+        }
+    }
+
+    // With hashes, appends the Zobrist hash of the state after every attack.
+    Outcome Reference::play(Side first, Side second, int maxRounds, std::vector<std::uint64_t> *hashes) {
+        int rounds = 0;
+        while (rounds < maxRounds && alive(first) > 0 && alive(second) > 0) {
+            attack(first, second);
+            if (hashes != nullptr) {
+                hashes->push_back(Zobrist::hash(toScenario(first, second)));
+            }
+            attack(second, first);
+            if (hashes != nullptr) {
+                hashes->push_back(Zobrist::hash(toScenario(first, second)));
+            }
+            rounds++;
+        }
+        return Match::result(toScenario(first, second), rounds);
+    }
+
+} // ariel
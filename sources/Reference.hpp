@@ -0,0 +1,34 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_REFERENCE_H
+#define COWBOY_VS_NINJA_A_REFERENCE_H
+
+#include "Match.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace ariel {
+
+    // The README rules written as plainly as possible, to check the optimized
+    // engines against. Members stay in insertion order and the traversal
+    // order is worked out again on every attack; nothing is cached, skipped
+    // or resolved in closed form. Keep it that way.
+    class Reference {
+    public:
+        struct Side {
+            std::vector<Fighter> members;
+            int leader = 0;
+            Ordering ordering = Ordering::CowboysFirst;
+        };
+
+        static Side fromRoster(const Roster &roster);
+        static Scenario toScenario(const Side &first, const Side &second);
+        static void attack(Side &attackers, Side &defenders);
+        static Outcome play(Side first, Side second, int maxRounds, std::vector<std::uint64_t> *hashes = nullptr);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_REFERENCE_H
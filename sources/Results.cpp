@@ -0,0 +1,179 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#include "Results.hpp"
+#include <cstring>
+
+namespace ariel {
+
+    static constexpr size_t HEADER = ResultWriter::MAGIC.size() + 2 * sizeof(std::uint32_t);
+    static constexpr size_t BLOCK_HEADER = 2 * sizeof(std::uint32_t);
+
+    size_t widthOf(Column column) {
+        switch (column) {
+            case Column::Scenario: return sizeof(std::uint64_t);
+            case Column::Rounds:
+            case Column::DamageFirst:
+            case Column::DamageSecond: return sizeof(std::int32_t);
+            default: return 1;
+        }
+    }
+
+    Column survivors(int side, Kind kind) {
+        int first = side == 0 ? (int) Column::FirstCowboys : (int) Column::SecondCowboys;
+        return static_cast<Column>(first + (int) kind);
+    }
+
+    static size_t padded(size_t bytes) {
+        return (bytes + 7) / 8 * 8;
+    }
+
+    static void count(const Roster &roster, int alive, std::array<std::uint8_t, 4> &kinds) {
+        kinds.fill(0);
+        if (alive == 0) {
+            return;
+        }
+        for (int i = 0; i < roster.size; ++i) {
+            const Fighter &member = roster.members[(size_t) i];
+            if (member.isAlive()) {
+                kinds[(size_t) member.kind]++;
+            }
+        }
+    }
+
+    ResultRow ResultRow::of(std::uint64_t scenario, const Scenario &start, const Scenario &end,
+                            const Outcome &outcome) {
+        ResultRow row{scenario, outcome.winner, outcome.rounds, {}, {},
+                      start.first.totalHealth() - outcome.healthFirst,
+                      start.second.totalHealth() - outcome.healthSecond};
+        count(end.first, outcome.aliveFirst, row.first);
+        count(end.second, outcome.aliveSecond, row.second);
+        return row;
+    }
+
+    ResultWriter::ResultWriter(const std::string &path, size_t blockRows)
+            : out(path, std::ios::binary | std::ios::trunc), blockRows(blockRows) {
+        if (blockRows == 0 || blockRows > UINT32_MAX) {
+            throw std::invalid_argument("a result block holds between one and 2^32 - 1 rows");
+        }
+        if (!out) {
+            throw std::runtime_error("could not open result file " + path);
+        }
+        std::uint32_t header[] = {VERSION, (std::uint32_t) COLUMNS};
+        out.write(MAGIC.data(), (std::streamsize) MAGIC.size());
+        out.write(reinterpret_cast<const char *>(header), sizeof header);
+        for (int c = 0; c < COLUMNS; ++c) {
+            columns[(size_t) c].resize(padded(blockRows * widthOf(static_cast<Column>(c))));
+        }
+    }
+
+    ResultWriter::~ResultWriter() {
+        try {
+            close();
+        } catch (...) {
+            // Destructors must not throw; call close() to see write errors.
+        }
+    }
+
+    template <class T>
+    void ResultWriter::put(Column column, T value) {
+        std::memcpy(columns[(size_t) column].data() + pending * sizeof(T), &value, sizeof(T));
+    }
+
+    void ResultWriter::append(const ResultRow &row) {
+        put(Column::Scenario, row.scenario);
+        put(Column::Winner, row.winner);
+        put(Column::Rounds, row.rounds);
+        for (int kind = 0; kind < 4; ++kind) {
+            put(survivors(0, static_cast<Kind>(kind)), row.first[(size_t) kind]);
+            put(survivors(1, static_cast<Kind>(kind)), row.second[(size_t) kind]);
+        }
+        put(Column::DamageFirst, row.damageFirst);
+        put(Column::DamageSecond, row.damageSecond);
+        if (++pending == blockRows) {
+            flush();
+        }
+    }
+
+    void ResultWriter::flush() {
+        if (pending == 0 || !out.is_open()) {
+            return;
+        }
+        std::uint32_t header[] = {(std::uint32_t) pending, 0};
+        out.write(reinterpret_cast<const char *>(header), sizeof header);
+        for (int c = 0; c < COLUMNS; ++c) {
+            out.write(columns[(size_t) c].data(),
+                      (std::streamsize) padded(pending * widthOf(static_cast<Column>(c))));
+        }
+        if (!out) {
+            throw std::runtime_error("could not write result block");
+        }
+        written += pending;
+        pending = 0;
+    }
+
+    void ResultWriter::close() {
+        if (!out.is_open()) {
+            return;
+        }
+        flush();
+        out.close();
+        if (out.fail()) {
+            throw std::runtime_error("could not close result file");
+        }
+    }
+
+    ResultReader::ResultReader(const std::string &path) : file(path) {
+        std::string_view bytes = file.bytes();
+        std::uint32_t header[2];
+        if (bytes.size() < HEADER || !bytes.starts_with(ResultWriter::MAGIC)) {
+            throw std::runtime_error(path + " is not a result file");
+        }
+        std::memcpy(header, bytes.data() + ResultWriter::MAGIC.size(), sizeof header);
+        if (header[0] != ResultWriter::VERSION || header[1] != (std::uint32_t) COLUMNS) {
+            throw std::runtime_error(path + " has an unsupported result format");
+        }
+        for (size_t at = HEADER; at < bytes.size();) {
+            std::uint32_t rows = 0;
+            if (bytes.size() - at < BLOCK_HEADER) {
+                throw std::runtime_error(path + " ends inside a block");
+            }
+            std::memcpy(&rows, bytes.data() + at, sizeof rows);
+            size_t length = BLOCK_HEADER;
+            for (int c = 0; c < COLUMNS; ++c) {
+                length += padded(rows * widthOf(static_cast<Column>(c)));
+            }
+            if (bytes.size() - at < length) {
+                throw std::runtime_error(path + " ends inside a block");
+            }
+            starts.push_back(at);
+            sizes.push_back(rows);
+            total += rows;
+            at += length;
+        }
+    }
+
+    const char *ResultReader::data(size_t block, Column column) const {
+        size_t rows = rowsIn(block);
+        size_t at = starts[block] + BLOCK_HEADER;
+        for (int c = 0; c < (int) column; ++c) {
+            at += padded(rows * widthOf(static_cast<Column>(c)));
+        }
+        return file.bytes().data() + at;
+    }
+
+    ResultRow ResultReader::row(size_t block, size_t index) const {
+        ResultRow row{column<std::uint64_t>(block, Column::Scenario)[index],
+                      column<Winner>(block, Column::Winner)[index],
+                      column<std::int32_t>(block, Column::Rounds)[index], {}, {},
+                      column<std::int32_t>(block, Column::DamageFirst)[index],
+                      column<std::int32_t>(block, Column::DamageSecond)[index]};
+        for (int kind = 0; kind < 4; ++kind) {
+            row.first[(size_t) kind] = column<std::uint8_t>(block, survivors(0, static_cast<Kind>(kind)))[index];
+            row.second[(size_t) kind] = column<std::uint8_t>(block, survivors(1, static_cast<Kind>(kind)))[index];
+        }
+        return row;
+    }
+
+} // ariel
@@ -0,0 +1,110 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_RESULTS_H
+#define COWBOY_VS_NINJA_A_RESULTS_H
+
+#include "Match.hpp"
+#include "MappedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ariel {
+
+    enum class Column : unsigned char {
+        Scenario,
+        Winner,
+        Rounds,
+        FirstCowboys, FirstYoungNinjas, FirstTrainedNinjas, FirstOldNinjas,
+        SecondCowboys, SecondYoungNinjas, SecondTrainedNinjas, SecondOldNinjas,
+        DamageFirst,
+        DamageSecond
+    };
+    constexpr int COLUMNS = 13;
+
+    // Bytes per value: the scenario id is a uint64_t, winner and survivors are
+    // one byte each, rounds and damage are int32_t.
+    size_t widthOf(Column column);
+    Column survivors(int side, Kind kind);
+
+    struct ResultRow {
+        std::uint64_t scenario;
+        Winner winner;
+        std::int32_t rounds;
+        // Survivors of each side by Kind.
+        std::array<std::uint8_t, 4> first;
+        std::array<std::uint8_t, 4> second;
+        // Health each side lost.
+        std::int32_t damageFirst;
+        std::int32_t damageSecond;
+
+        // end is the scenario as Match::playInPlace left it.
+        static ResultRow of(std::uint64_t scenario, const Scenario &start, const Scenario &end,
+                            const Outcome &outcome);
+    };
+
+    // Results stored by column. The file is a header and then blocks of up to
+    // blockRows rows, each holding its row count followed by every column's
+    // values back to back, padded to eight bytes. A reader aggregating one
+    // column touches only that column's pages.
+    class ResultWriter {
+        std::ofstream out;
+        size_t blockRows;
+        size_t pending = 0;
+        std::uint64_t written = 0;
+        std::array<std::vector<char>, COLUMNS> columns;
+
+        template <class T> void put(Column column, T value);
+
+    public:
+        static constexpr std::string_view MAGIC{"CNRESLT1", 8};
+        static constexpr std::uint32_t VERSION = 1;
+        static constexpr size_t DEFAULT_BLOCK_ROWS = 1 << 16;
+
+        explicit ResultWriter(const std::string &path, size_t blockRows = DEFAULT_BLOCK_ROWS);
+        ~ResultWriter();
+        ResultWriter(const ResultWriter &) = delete;
+        ResultWriter &operator=(const ResultWriter &) = delete;
+
+        void append(const ResultRow &row);
+        // Writes the rows appended so far as a block of their own.
+        void flush();
+        void close();
+        std::uint64_t rows() const { return written + pending; }
+    };
+
+    class ResultReader {
+        MappedFile file;
+        std::vector<size_t> starts;
+        std::vector<std::uint32_t> sizes;
+        std::uint64_t total = 0;
+
+        const char *data(size_t block, Column column) const;
+
+    public:
+        explicit ResultReader(const std::string &path);
+
+        size_t blocks() const { return starts.size(); }
+        std::uint64_t rows() const { return total; }
+        size_t rowsIn(size_t block) const { return sizes.at(block); }
+
+        // T must have the column's width, e.g. std::int32_t for Rounds.
+        template <class T>
+        std::span<const T> column(size_t block, Column column) const {
+            if (sizeof(T) != widthOf(column)) {
+                throw std::invalid_argument("column read with a type of the wrong width");
+            }
+            return {reinterpret_cast<const T *>(data(block, column)), rowsIn(block)};
+        }
+
+        ResultRow row(size_t block, size_t index) const;
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_RESULTS_H
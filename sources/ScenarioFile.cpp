@@ -0,0 +1,153 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#include "ScenarioFile.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace ariel {
+
+    ScenarioFile::ScenarioFile(const std::string &path) : file(path) {
+        if (file.bytes().starts_with(BINARY_MAGIC)) {
+            view = viewBinary(file.bytes());
+        } else {
+            parseText(file.bytes(), parsed);
+            view = parsed;
+        }
+    }
+
+    static const char *skipBlanks(const char *at, const char *end) {
+        while (at < end && (*at == ' ' || *at == '\t' || *at == '\r')) {
+            ++at;
+        }
+        return at;
+    }
+
+    [[noreturn]] static void malformed(size_t line, const char *problem) {
+        throw std::runtime_error("scenario line " + std::to_string(line) + ": " + problem);
+    }
+
+    static Kind kindOf(char letter, size_t line) {
+        switch (letter) {
+            case 'c': return Kind::Cowboy;
+            case 'y': return Kind::YoungNinja;
+            case 't': return Kind::TrainedNinja;
+            case 'o': return Kind::OldNinja;
+            default: malformed(line, "unknown fighter kind");
+        }
+    }
+
+    static double coordinate(const char *&at, const char *end, size_t line) {
+        at = skipBlanks(at, end);
+        double value = 0;
+        auto [next, error] = std::from_chars(at, end, value);
+        if (error != std::errc() || !isFinite(value)) {
+            malformed(line, "expected a coordinate");
+        }
+        at = next;
+        return value;
+    }
+
+    // Fills a default constructed roster where it lies, so a scenario is
+    // never copied on its way into the array.
+    static void team(const char *&at, const char *end, size_t line, Roster &roster) {
+        at = skipBlanks(at, end);
+        if (at == end || (*at != 'C' && *at != 'I')) {
+            malformed(line, "expected the team ordering C or I");
+        }
+        roster.ordering = *at++ == 'C' ? Ordering::CowboysFirst : Ordering::Insertion;
+        for (at = skipBlanks(at, end); at < end && *at != '|'; at = skipBlanks(at, end)) {
+            if (roster.size == MAX_MEMBERS) {
+                malformed(line, "a team can not have more than ten members");
+            }
+            Kind kind = kindOf(*at++, line);
+            double x = coordinate(at, end, line);
+            double y = coordinate(at, end, line);
+            roster.add(kind, x, y);
+        }
+        if (roster.size == 0) {
+            malformed(line, "a team needs at least one member");
+        }
+    }
+
+    void ScenarioFile::parseText(std::string_view text, std::vector<Scenario> &into) {
+        into.reserve(into.size() + (size_t) std::count(text.begin(), text.end(), '\n') + 1);
+        const char *at = text.data();
+        const char *end = at + text.size();
+        for (size_t line = 1; at < end; ++line) {
+            const char *lineEnd = static_cast<const char *>(std::memchr(at, '\n', (size_t) (end - at)));
+            lineEnd = lineEnd == nullptr ? end : lineEnd;
+            at = skipBlanks(at, lineEnd);
+            if (at < lineEnd && *at != '#') {
+                Scenario &scenario = into.emplace_back();
+                team(at, lineEnd, line, scenario.first);
+                if (at == lineEnd) {
+                    malformed(line, "expected '|' before the second team");
+                }
+                ++at;
+                team(at, lineEnd, line, scenario.second);
+                if (at < lineEnd) {
+                    malformed(line, "unexpected text after the second team");
+                }
+            }
+            at = lineEnd + 1;
+        }
+    }
+
+    std::span<const Scenario> ScenarioFile::viewBinary(std::string_view bytes) {
+        std::uint64_t count = 0;
+        if (bytes.size() < BINARY_MAGIC.size() + sizeof count || !bytes.starts_with(BINARY_MAGIC)) {
+            throw std::runtime_error("not a binary scenario file");
+        }
+        std::memcpy(&count, bytes.data() + BINARY_MAGIC.size(), sizeof count);
+        size_t header = BINARY_MAGIC.size() + sizeof count;
+        if ((bytes.size() - header) / sizeof(Scenario) != count || (bytes.size() - header) % sizeof(Scenario) != 0) {
+            throw std::runtime_error("binary scenario file is truncated");
+        }
+        const char *first = bytes.data() + header;
+        if (reinterpret_cast<std::uintptr_t>(first) % alignof(Scenario) != 0) {
+            throw std::runtime_error("binary scenarios are not aligned");
+        }
+        std::span<const Scenario> scenarios(reinterpret_cast<const Scenario *>(first), (size_t) count);
+        for (const Scenario &scenario: scenarios) {
+            if (!scenario.first.isValid() || !scenario.second.isValid()) {
+                throw std::runtime_error("binary scenario file holds a malformed team");
+            }
+        }
+        return scenarios;
+    }
+
+    // Only positions are written; health and bullets are back to full when
+    // the text is read again.
+    void ScenarioFile::writeText(std::ostream &out, std::span<const Scenario> scenarios) {
+        static const char letters[] = {'c', 'y', 't', 'o'};
+        char buffer[32];
+        for (const Scenario &scenario: scenarios) {
+            for (const Roster *roster: {&scenario.first, &scenario.second}) {
+                out << (roster == &scenario.first ? "" : " | ")
+                    << (roster->ordering == Ordering::CowboysFirst ? 'C' : 'I');
+                for (int i = 0; i < roster->size; ++i) {
+                    const Fighter &member = roster->members[(size_t) i];
+                    out << ' ' << letters[(size_t) member.kind];
+                    for (double value: {member.x, member.y}) {
+                        char *written = std::to_chars(buffer, buffer + sizeof buffer, value).ptr;
+                        out << ' ' << std::string_view(buffer, (size_t) (written - buffer));
+                    }
+                }
+            }
+            out << '\n';
+        }
+    }
+
+    void ScenarioFile::writeBinary(std::ostream &out, std::span<const Scenario> scenarios) {
+        std::uint64_t count = scenarios.size();
+        out.write(BINARY_MAGIC.data(), (std::streamsize) BINARY_MAGIC.size());
+        out.write(reinterpret_cast<const char *>(&count), sizeof count);
+        out.write(reinterpret_cast<const char *>(scenarios.data()), (std::streamsize) scenarios.size_bytes());
+    }
+
+} // ariel
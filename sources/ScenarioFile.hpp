@@ -0,0 +1,55 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_SCENARIOFILE_H
+#define COWBOY_VS_NINJA_A_SCENARIOFILE_H
+
+#include "Match.hpp"
+#include "MappedFile.hpp"
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ariel {
+
+    // A file of scenarios, memory mapped for reading.
+    //
+    // Text files have one scenario per line, the two teams split by '|'. A
+    // team is its ordering, C (cowboys first) or I (insertion), followed by
+    // its members as a kind letter c, y, t or o and the x and y coordinates;
+    // the first member leads. Blank lines and lines starting with '#' are
+    // skipped:
+    //
+    //     C c 0 0 y 3.5 4 | I o 20 3 t 21 3
+    //
+    // Binary files are BINARY_MAGIC, a 64 bit scenario count and then the
+    // Scenario structs themselves in native byte order, so they are used in
+    // place without any copy. Text is parsed straight out of the mapping
+    // with no allocation besides the scenario array, but it still reads every
+    // digit: ten million fighters written at full precision are about 390 MB
+    // of text and take over a second, where the binary file loads in about a
+    // tenth of one. Convert large batches to binary once.
+    class ScenarioFile {
+        MappedFile file;
+        std::vector<Scenario> parsed;
+        std::span<const Scenario> view;
+
+    public:
+        static constexpr std::string_view BINARY_MAGIC{"CNSCENE1", 8};
+
+        explicit ScenarioFile(const std::string &path);
+
+        std::span<const Scenario> scenarios() const { return view; }
+        bool binary() const { return parsed.empty() && !view.empty(); }
+
+        static void parseText(std::string_view text, std::vector<Scenario> &into);
+        static std::span<const Scenario> viewBinary(std::string_view bytes);
+        static void writeText(std::ostream &out, std::span<const Scenario> scenarios);
+        static void writeBinary(std::ostream &out, std::span<const Scenario> scenarios);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_SCENARIOFILE_H
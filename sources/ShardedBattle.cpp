@@ -0,0 +1,185 @@
+//
+// Created by avida on 5/22/2023.
+//
+
+#include "ShardedBattle.hpp"
+#include <algorithm>
+#include <barrier>
+#include <thread>
+
+namespace ariel {
+
+    ShardedBattle::ShardedBattle(Battle battle, unsigned threads, double cellSize) : shards(threads) {
+        armies.push_back(std::move(battle.first));
+        armies.push_back(std::move(battle.second));
+        index = SpatialIndex(armies, cellSize > 0 ? cellSize : SpatialIndex::defaultCellSize(armies));
+        if (shards == 0) {
+            shards = std::max(1U, std::thread::hardware_concurrency());
+        }
+        shards = std::min<unsigned>(shards, (unsigned) index.columnCount());
+        removals.resize((size_t) shards * shards);
+        insertions.resize((size_t) shards * shards);
+        alive = {armies[0].stillAlive(), armies[1].stillAlive()};
+        for (size_t side = 0; side < armies.size(); ++side) {
+            chased[side].assign(armies[side].members.size(), IDLE);
+        }
+    }
+
+    int ShardedBattle::shardOf(int cell) const {
+        return (int) ((long) index.columnOf(cell) * shards / index.columnCount());
+    }
+
+    // Serial part of a turn: Match::attack with the grid for the victim and
+    // leader queries. Only the leader walks right away, since later victims
+    // are picked by its position, and the victim walk restarts from there.
+    // Returns false when there is nothing left to attack.
+    bool ShardedBattle::attack(int side) {
+        Army &attackers = armies[(size_t) side];
+        Army &defenders = armies[(size_t) (1 - side)];
+        std::vector<int> &targets = chased[(size_t) side];
+        if (alive[(size_t) side] == 0 || alive[(size_t) (1 - side)] == 0) {
+            return false;
+        }
+        const Fighter &former = attackers.members[(size_t) attackers.leader];
+        if (!former.isAlive()) {
+            attackers.leader = index.closestMember(armies, side, former.x, former.y).member;
+        }
+        Fighter &leader = attackers.members[(size_t) attackers.leader];
+        victims.start(index, armies, side, leader.x, leader.y);
+        int victim = victims.next().member;
+        for (int i = 0; i < attackers.size; ++i) {
+            Fighter &attacker = attackers.members[(size_t) i];
+            if (!attacker.isAlive()) {
+                continue;
+            }
+            if (!defenders.members[(size_t) victim].isAlive()) {
+                victim = victims.next().member;
+                if (victim < 0) {
+                    break;
+                }
+            }
+            Fighter &target = defenders.members[(size_t) victim];
+            if (attacker.isCowboy()) {
+                target.health -= attacker.bullets > 0 ? BULLET_DAMAGE : 0;
+                targets[(size_t) i] = victim;
+            } else if (distance(attacker, target) < SLASH_RANGE) {
+                target.health -= SLASH_DAMAGE;
+            } else if (i == attackers.leader) {
+                moveTowards(attacker, target, speedOf(attacker.kind));
+                index.move(attacker, SpatialIndex::Entry{side, i});
+                victims.start(index, armies, side, leader.x, leader.y);
+            } else {
+                targets[(size_t) i] = victim;
+            }
+            if (!target.isAlive()) {
+                index.remove(SpatialIndex::Entry{1 - side, victim});
+                alive[(size_t) (1 - side)]--;
+            }
+        }
+        return true;
+    }
+
+    // Applies the recorded actions of one slice of the attackers, clearing
+    // them for the next turn, and sorts the cell changes by the shards that
+    // own the cells.
+    void ShardedBattle::walk(int side, unsigned thread) {
+        Army &attackers = armies[(size_t) side];
+        const Army &defenders = armies[(size_t) (1 - side)];
+        std::vector<int> &targets = chased[(size_t) side];
+        for (unsigned shard = 0; shard < shards; ++shard) {
+            removals[(size_t) (thread * shards + shard)].clear();
+            insertions[(size_t) (thread * shards + shard)].clear();
+        }
+        size_t begin = targets.size() * thread / shards;
+        size_t end = targets.size() * (thread + 1) / shards;
+        for (size_t i = begin; i < end; ++i) {
+            int target = targets[i];
+            if (target == IDLE) {
+                continue;
+            }
+            targets[i] = IDLE;
+            Fighter &attacker = attackers.members[i];
+            if (attacker.isCowboy()) {
+                attacker.bullets = attacker.bullets > 0 ? attacker.bullets - 1 : COWBOY_BULLETS;
+                continue;
+            }
+            moveTowards(attacker, defenders.members[(size_t) target], speedOf(attacker.kind));
+            int from = index.cellOf(SpatialIndex::Entry{side, (int) i});
+            int to = index.cellOf(attacker.x, attacker.y);
+            if (from != to) {
+                Change change{(int) i, from, to};
+                removals[(size_t) thread * shards + (size_t) shardOf(from)].push_back(change);
+                insertions[(size_t) thread * shards + (size_t) shardOf(to)].push_back(change);
+            }
+        }
+    }
+
+    void ShardedBattle::remove(int side, unsigned shard) {
+        for (unsigned thread = 0; thread < shards; ++thread) {
+            for (const Change &change: removals[(size_t) (thread * shards + shard)]) {
+                index.remove(SpatialIndex::Entry{side, change.member});
+            }
+        }
+    }
+
+    void ShardedBattle::insert(int side, unsigned shard) {
+        for (unsigned thread = 0; thread < shards; ++thread) {
+            for (const Change &change: insertions[(size_t) (thread * shards + shard)]) {
+                index.move(armies[(size_t) side].members[(size_t) change.member], SpatialIndex::Entry{side, change.member});
+            }
+        }
+    }
+
+    Outcome ShardedBattle::play(int maxRounds) {
+        std::barrier phase((std::ptrdiff_t) shards);
+        int side = 0;
+        bool finished = false;
+        auto parallel = [&](unsigned thread) {
+            walk(side, thread);
+            phase.arrive_and_wait();
+            remove(side, thread);
+            phase.arrive_and_wait();
+            insert(side, thread);
+            phase.arrive_and_wait();
+        };
+        // Each worker waits for the serial pass of a turn, plays its shard and
+        // waits for the others; the barrier orders everything in between.
+        std::vector<std::jthread> pool;
+        pool.reserve(shards - 1);
+        for (unsigned thread = 1; thread < shards; ++thread) {
+            pool.emplace_back([&, thread] {
+                while (true) {
+                    phase.arrive_and_wait();
+                    if (finished) {
+                        return;
+                    }
+                    parallel(thread);
+                }
+            });
+        }
+        auto turn = [&](int attacking) {
+            if (attack(attacking)) {
+                side = attacking;
+                phase.arrive_and_wait();
+                parallel(0);
+            }
+        };
+        int rounds = 0;
+        while (rounds < maxRounds && alive[0] > 0 && alive[1] > 0) {
+            turn(0);
+            turn(1);
+            rounds++;
+        }
+        finished = true;
+        phase.arrive_and_wait();
+        pool.clear();
+        Winner winner = Winner::Undecided;
+        if (alive[1] == 0 && alive[0] > 0) {
+            winner = Winner::First;
+        } else if (alive[0] == 0 && alive[1] > 0) {
+            winner = Winner::Second;
+        }
+        return Outcome{winner, rounds, alive[0], alive[1], armies[0].totalHealth(), armies[1].totalHealth()};
+    }
+
+} // ariel
@@ -0,0 +1,65 @@
+//
+// Created by avida on 5/22/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_SHARDEDBATTLE_H
+#define COWBOY_VS_NINJA_A_SHARDEDBATTLE_H
+
+#include "SpatialIndex.hpp"
+#include <array>
+#include <vector>
+
+namespace ariel {
+
+    // Plays very large battles on several threads with the results of
+    // Match::attack.
+    //
+    // The battlefield grid is split into vertical strips, one shard per thread.
+    // Every turn starts with a serial pass that walks the attackers in order,
+    // deals all damage and picks victims through the grid; it only records
+    // which victim each walking ninja chases. The shards then move their
+    // ninjas, reload or spend bullets and clear what was recorded in
+    // parallel, and fighters whose cell changed are handed to the shard that
+    // owns the old and the new cell, so no two threads ever touch the same
+    // cell. Victims stand still during the attackers' turn and a ninja only
+    // reads its own position, so the parallel part does not depend on the
+    // number of threads. play() starts the threads once and they meet at one
+    // barrier between the phases of every turn.
+    class ShardedBattle {
+        static constexpr int IDLE = -1;
+
+        struct Change {
+            int member;
+            int from;
+            int to;
+        };
+
+        std::vector<Army> armies;
+        std::array<int, 2> alive{};
+        SpatialIndex index;
+        unsigned shards;
+        SpatialIndex::Nearest victims;
+        // The victim each member of an army acts on this turn, or IDLE.
+        std::array<std::vector<int>, 2> chased;
+        // removals/insertions[thread * shards + shard]
+        std::vector<std::vector<Change>> removals;
+        std::vector<std::vector<Change>> insertions;
+
+        int shardOf(int cell) const;
+        bool attack(int side);
+        void walk(int side, unsigned thread);
+        void remove(int side, unsigned shard);
+        void insert(int side, unsigned shard);
+
+    public:
+        explicit ShardedBattle(Battle battle, unsigned threads = 0, double cellSize = 0);
+
+        Outcome play(int maxRounds = MAX_ROUNDS);
+        const Army &first() const { return armies[0]; }
+        const Army &second() const { return armies[1]; }
+        unsigned threads() const { return shards; }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_SHARDEDBATTLE_H
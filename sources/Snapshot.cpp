@@ -0,0 +1,65 @@
+//
+// Created by avida on 5/26/2023.
+//
+
+#include "Snapshot.hpp"
+#include <cstring>
+
+namespace ariel {
+
+    void SnapshotPublisher::publish(const Scenario &scenario, int round, int halfTurns, bool finished) {
+        std::uint64_t version = latest.load(std::memory_order_relaxed) + 1;
+        Snapshot snapshot{scenario, version, round, halfTurns, finished};
+        std::array<std::uint64_t, WORDS> words{};
+        std::memcpy(words.data(), &snapshot, sizeof snapshot);
+        Slot &slot = slots[version & 1];
+        std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        latest.store(version, std::memory_order_release);
+    }
+
+    bool SnapshotPublisher::read(Snapshot &out) const {
+        std::array<std::uint64_t, WORDS> words{};
+        for (;;) {
+            std::uint64_t version = latest.load(std::memory_order_acquire);
+            if (version == 0) {
+                return false;
+            }
+            const Slot &slot = slots[version & 1];
+            std::uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before % 2 != 0) {
+                continue;
+            }
+            for (size_t i = 0; i < WORDS; ++i) {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before) {
+                std::memcpy(&out, words.data(), sizeof out);
+                return true;
+            }
+        }
+    }
+
+    Outcome SnapshotPublisher::play(Scenario scenario, int maxRounds) {
+        int rounds = 0;
+        int halfTurns = 0;
+        while (rounds < maxRounds && scenario.first.stillAlive() > 0 && scenario.second.stillAlive() > 0) {
+            Match::attack(scenario.first, scenario.second);
+            publish(scenario, rounds, ++halfTurns);
+            if (scenario.second.stillAlive() > 0) {
+                Match::attack(scenario.second, scenario.first);
+                publish(scenario, rounds, ++halfTurns);
+            }
+            rounds++;
+        }
+        publish(scenario, rounds, halfTurns, true);
+        return Match::result(scenario, rounds);
+    }
+
+} // ariel
@@ -0,0 +1,58 @@
+//
+// Created by avida on 5/26/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_SNAPSHOT_H
+#define COWBOY_VS_NINJA_A_SNAPSHOT_H
+
+#include "Match.hpp"
+#include "Turns.hpp"
+#include <atomic>
+#include <cstdint>
+
+namespace ariel {
+
+    // State of a match between two attacks. Liveness is health above zero.
+    struct Snapshot {
+        Scenario scenario;
+        std::uint64_t version = 0;
+        int round = 0;
+        int halfTurns = 0;
+        bool finished = false;
+    };
+
+    // Publishes snapshots of a running match for any number of reader threads
+    // through a double-buffered seqlock. The engine thread writes into the
+    // slot readers are not being sent to and never waits; a reader copies the
+    // latest slot and retries only if the writer has lapped it meanwhile, so
+    // it never sees a half-applied attack. Slots are stored as relaxed atomic
+    // words, so the racing copies are well defined.
+    class SnapshotPublisher {
+        static constexpr size_t WORDS = (sizeof(Snapshot) + 7) / 8;
+
+        struct alignas(64) Slot {
+            std::atomic<std::uint64_t> sequence{0};
+            std::array<std::atomic<std::uint64_t>, WORDS> words{};
+        };
+
+        std::array<Slot, 2> slots;
+        alignas(64) std::atomic<std::uint64_t> latest{0};
+
+    public:
+        // Only one thread may publish.
+        void publish(const Scenario &scenario, int round, int halfTurns, bool finished = false);
+        void publish(const TurnView &view) { publish(*view.scenario, view.round, view.halfTurns); }
+
+        // Copies the latest snapshot into out; false while nothing has been
+        // published yet.
+        bool read(Snapshot &out) const;
+        std::uint64_t version() const { return latest.load(std::memory_order_acquire); }
+
+        // Plays the match attack by attack on the calling thread, publishing
+        // after every attack and once more when it is over.
+        Outcome play(Scenario scenario, int maxRounds = MAX_ROUNDS);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_SNAPSHOT_H
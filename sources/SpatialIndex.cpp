@@ -0,0 +1,231 @@
+//
+// Created by avida on 5/22/2023.
+//
+
+#include "SpatialIndex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace ariel {
+
+    static constexpr int MAX_CELLS = 1 << 21;
+
+    SpatialIndex::SpatialIndex(const std::vector<Army> &teams, double cellSize) {
+        reset(teams, cellSize);
+    }
+
+    // Cells past the end of a smaller grid are kept, empty or not, so that
+    // indexing battle after battle stops allocating once it has seen the
+    // largest; nothing ever looks beyond columns * rows.
+    void SpatialIndex::reset(const std::vector<Army> &teams, double cellSize) {
+        if (!(cellSize > 0)) {
+            throw std::invalid_argument("cell size must be positive");
+        }
+        cell = cellSize;
+        left = 0;
+        bottom = 0;
+        double right = 0;
+        double top = 0;
+        bool first = true;
+        for (const Army &army: teams) {
+            for (const Fighter &member: army.members) {
+                if (!member.isAlive()) {
+                    continue;
+                }
+                left = first ? member.x : std::min(left, member.x);
+                bottom = first ? member.y : std::min(bottom, member.y);
+                right = first ? member.x : std::max(right, member.x);
+                top = first ? member.y : std::max(top, member.y);
+                first = false;
+            }
+        }
+        while (((right - left) / cell + 1) * ((top - bottom) / cell + 1) > MAX_CELLS) {
+            cell *= 2;
+        }
+        columns = (int) ((right - left) / cell) + 1;
+        rows = (int) ((top - bottom) / cell) + 1;
+        size_t count = (size_t) columns * (size_t) rows;
+        if (cells.size() < count) {
+            cells.resize(count);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            cells[i].clear();
+        }
+        slots.resize(teams.size());
+        for (size_t team = 0; team < teams.size(); ++team) {
+            slots[team].assign(teams[team].members.size(), Slot{-1, -1});
+            for (size_t member = 0; member < teams[team].members.size(); ++member) {
+                if (teams[team].members[member].isAlive()) {
+                    move(teams[team].members[member], Entry{(int) team, (int) member});
+                }
+            }
+        }
+    }
+
+    int SpatialIndex::column(double x) const {
+        return std::clamp((int) ((x - left) / cell), 0, columns - 1);
+    }
+
+    int SpatialIndex::row(double y) const {
+        return std::clamp((int) ((y - bottom) / cell), 0, rows - 1);
+    }
+
+    void SpatialIndex::move(const Fighter &fighter, Entry entry) {
+        int target = cellOf(fighter.x, fighter.y);
+        Slot &slot = slots[(size_t) entry.team][(size_t) entry.member];
+        if (slot.cell == target) {
+            return;
+        }
+        if (slot.cell >= 0) {
+            remove(entry);
+        }
+        std::vector<Entry> &entries = cells[(size_t) target];
+        slot = Slot{target, (int) entries.size()};
+        entries.push_back(entry);
+    }
+
+    void SpatialIndex::remove(Entry entry) {
+        Slot &slot = slots[(size_t) entry.team][(size_t) entry.member];
+        if (slot.cell < 0) {
+            return;
+        }
+        std::vector<Entry> &entries = cells[(size_t) slot.cell];
+        Entry last = entries.back();
+        entries[(size_t) slot.index] = last;
+        slots[(size_t) last.team][(size_t) last.member].index = slot.index;
+        entries.pop_back();
+        slot = Slot{-1, -1};
+    }
+
+    // Calls visit with the entries of every cell in the square ring of cells
+    // `ring` steps away from the center cell, clipped to the grid.
+    template <class Visit>
+    void SpatialIndex::visitRing(int centerColumn, int centerRow, int ring, Visit visit) const {
+        int first = std::max(centerColumn - ring, 0);
+        int last = std::min(centerColumn + ring, columns - 1);
+        auto line = [&](int row) {
+            if (row < 0 || row >= rows) {
+                return;
+            }
+            for (int col = first; col <= last; ++col) {
+                visit(cells[(size_t) (row * columns + col)]);
+            }
+        };
+        line(centerRow - ring);
+        if (ring == 0) {
+            return;
+        }
+        line(centerRow + ring);
+        for (int row = std::max(centerRow - ring + 1, 0); row < std::min(centerRow + ring, rows); ++row) {
+            if (centerColumn - ring >= 0) {
+                visit(cells[(size_t) (row * columns + centerColumn - ring)]);
+            }
+            if (centerColumn + ring < columns) {
+                visit(cells[(size_t) (row * columns + centerColumn + ring)]);
+            }
+        }
+    }
+
+    // Everything in ring r is at least (r - 1) cells away from the query point,
+    // so a search can stop once that bound passes the best distance found; the
+    // slack keeps rounding from cutting it short.
+    bool SpatialIndex::beyond(int ring, double length) const {
+        return (ring - 1) * cell > length * (1 + 1e-9);
+    }
+
+    template <bool Hostile>
+    SpatialIndex::Entry SpatialIndex::closest(const std::vector<Army> &teams, int team, double x, double y) const {
+        Entry found{-1, -1};
+        double best = std::numeric_limits<double>::infinity();
+        auto scan = [&](const std::vector<Entry> &entries) {
+            for (const Entry &entry: entries) {
+                if ((entry.team == team) == Hostile) {
+                    continue;
+                }
+                const Fighter &fighter = teams[(size_t) entry.team].members[(size_t) entry.member];
+                double length = distance(x, y, fighter.x, fighter.y);
+                if (length < best || (length == best && (entry.team < found.team ||
+                                                         (entry.team == found.team && entry.member < found.member)))) {
+                    best = length;
+                    found = entry;
+                }
+            }
+        };
+        int rings = std::max(columns, rows);
+        for (int ring = 0; ring <= rings && (found.team < 0 || !beyond(ring, best)); ++ring) {
+            visitRing(column(x), row(y), ring, scan);
+        }
+        return found;
+    }
+
+    void SpatialIndex::Nearest::start(const SpatialIndex &grid, const std::vector<Army> &armies, int own, double x,
+                                      double y) {
+        index = &grid;
+        teams = &armies;
+        team = own;
+        centerX = x;
+        centerY = y;
+        ring = 0;
+        heap.clear();
+    }
+
+    SpatialIndex::Entry SpatialIndex::Nearest::next() {
+        int rings = std::max(index->columns, index->rows);
+        auto scan = [this](const std::vector<Entry> &entries) {
+            for (const Entry &entry: entries) {
+                if (entry.team != team) {
+                    const Fighter &fighter = (*teams)[(size_t) entry.team].members[(size_t) entry.member];
+                    heap.push(Candidate{distance(centerX, centerY, fighter.x, fighter.y), entry});
+                }
+            }
+        };
+        while (true) {
+            while (ring <= rings && (heap.empty() || !index->beyond(ring, heap.top().length))) {
+                index->visitRing(index->column(centerX), index->row(centerY), ring, scan);
+                ring++;
+            }
+            if (heap.empty()) {
+                return Entry{-1, -1};
+            }
+            Entry entry = heap.pop().entry;
+            if ((*teams)[(size_t) entry.team].members[(size_t) entry.member].isAlive()) {
+                return entry;
+            }
+        }
+    }
+
+    SpatialIndex::Entry SpatialIndex::closestHostile(const std::vector<Army> &teams, int team, double x,
+                                                     double y) const {
+        return closest<true>(teams, team, x, y);
+    }
+
+    SpatialIndex::Entry SpatialIndex::closestMember(const std::vector<Army> &teams, int team, double x,
+                                                    double y) const {
+        return closest<false>(teams, team, x, y);
+    }
+
+    double SpatialIndex::defaultCellSize(const std::vector<Army> &teams) {
+        double left = 0;
+        double bottom = 0;
+        double right = 0;
+        double top = 0;
+        int count = 0;
+        for (const Army &army: teams) {
+            for (const Fighter &member: army.members) {
+                if (!member.isAlive()) {
+                    continue;
+                }
+                left = count == 0 ? member.x : std::min(left, member.x);
+                bottom = count == 0 ? member.y : std::min(bottom, member.y);
+                right = count == 0 ? member.x : std::max(right, member.x);
+                top = count == 0 ? member.y : std::max(top, member.y);
+                count++;
+            }
+        }
+        double area = std::max(right - left, 1.0) * std::max(top - bottom, 1.0);
+        return std::max(std::sqrt(2 * area / std::max(count, 1)), 1e-6);
+    }
+
+} // ariel
@@ -0,0 +1,104 @@
+//
+// Created by avida on 5/22/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_SPATIALINDEX_H
+#define COWBOY_VS_NINJA_A_SPATIALINDEX_H
+
+#include "Army.hpp"
+#include "PairingHeap.hpp"
+#include <vector>
+
+namespace ariel {
+
+    // Uniform grid over the living fighters of every team. Ninjas only walk
+    // towards other fighters, so nobody ever leaves the bounding box of the
+    // starting positions and the grid never has to grow.
+    class SpatialIndex {
+    public:
+        struct Entry {
+            int team;
+            int member;
+        };
+
+        // Walks the living hostiles of a team from the closest outwards, with
+        // the tie-break of closestHostile. Each cell is scanned once, so when
+        // a whole army attacks from one spot, picking victim after victim
+        // costs no more than a single search through the hole the earlier
+        // victims left. Hostiles must not move while it is in use.
+        class Nearest {
+            struct Candidate {
+                double length;
+                Entry entry;
+
+                bool operator<(const Candidate &other) const {
+                    if (length != other.length) {
+                        return length < other.length;
+                    }
+                    return entry.team != other.entry.team ? entry.team < other.entry.team
+                                                          : entry.member < other.entry.member;
+                }
+            };
+
+            const SpatialIndex *index = nullptr;
+            const std::vector<Army> *teams = nullptr;
+            int team = 0;
+            double centerX = 0;
+            double centerY = 0;
+            int ring = 0;
+            PairingHeap<Candidate> heap;
+
+        public:
+            void start(const SpatialIndex &grid, const std::vector<Army> &armies, int own, double x, double y);
+            Entry next();
+        };
+
+    private:
+        struct Slot {
+            int cell;
+            int index;
+        };
+
+        double left = 0;
+        double bottom = 0;
+        double cell = 1;
+        int columns = 1;
+        int rows = 1;
+        std::vector<std::vector<Entry>> cells;
+        std::vector<std::vector<Slot>> slots;
+
+        int row(double y) const;
+        bool beyond(int ring, double length) const;
+        template <class Visit>
+        void visitRing(int centerColumn, int centerRow, int ring, Visit visit) const;
+        template <bool Hostile>
+        Entry closest(const std::vector<Army> &teams, int team, double x, double y) const;
+
+    public:
+        SpatialIndex() = default;
+        SpatialIndex(const std::vector<Army> &teams, double cellSize);
+
+        // Indexes the living fighters of teams afresh, reusing the storage.
+        void reset(const std::vector<Army> &teams, double cellSize);
+
+        // About two living fighters per cell over the bounding box.
+        static double defaultCellSize(const std::vector<Army> &teams);
+
+        // Puts the entry in the cell of the fighter's position, inserting it if
+        // it is not indexed.
+        void move(const Fighter &fighter, Entry entry);
+        void remove(Entry entry);
+        Entry closestHostile(const std::vector<Army> &teams, int team, double x, double y) const;
+        Entry closestMember(const std::vector<Army> &teams, int team, double x, double y) const;
+
+        int column(double x) const;
+        int cellOf(double x, double y) const { return row(y) * columns + column(x); }
+        int cellOf(Entry entry) const { return slots[(size_t) entry.team][(size_t) entry.member].cell; }
+        int columnOf(int cell) const { return cell % columns; }
+        int columnCount() const { return columns; }
+        int cellCount() const { return columns * rows; }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_SPATIALINDEX_H
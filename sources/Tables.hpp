@@ -0,0 +1,67 @@
+//
+// Created by avida on 5/25/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_TABLES_H
+#define COWBOY_VS_NINJA_A_TABLES_H
+
+#include "Endgame.hpp"
+#include <algorithm>
+
+namespace ariel {
+
+    // Static checks, worked out by the compiler playing the constexpr rules,
+    // that the closed forms the fast paths rely on agree with matches played
+    // attack by attack. Nothing here is used at run time; the duel table
+    // Endgame reads is worked out by the compiler in Endgame.cpp.
+
+    // Winner, rounds and health left of a one on one match between fresh
+    // fighters, the first at the origin and the second apart units away
+    // diagonally, played attack by attack.
+    constexpr Outcome duel(Kind first, Kind second, double apart) {
+        Scenario scenario;
+        scenario.first.add(first, 0, 0);
+        scenario.second.add(second, apart, apart);
+        return Match::stepByStep(scenario);
+    }
+
+    // What Endgame::resolve answers for the same duel.
+    constexpr Outcome resolvedDuel(Kind first, Kind second, double apart) {
+        Duelist one{};
+        Duelist other{};
+        Fighter attacker{0, 0, startingHealth(first), first == Kind::Cowboy ? COWBOY_BULLETS : 0, first};
+        Fighter defender{apart, apart, startingHealth(second), second == Kind::Cowboy ? COWBOY_BULLETS : 0, second};
+        Endgame::approach(attacker, defender, one, other, MAX_ROUNDS);
+        Duel result = Endgame::fight(one, attacker.health, other, defender.health);
+        bool firstWins = result.winner == Winner::First;
+        return Outcome{result.winner, result.rounds, firstWins ? 1 : 0, firstWins ? 0 : 1,
+                       std::max(attacker.health - result.damageSecond, 0),
+                       std::max(defender.health - result.damageFirst, 0)};
+    }
+
+    // One kind at a time, to stay well inside the compilers' constant
+    // evaluation step limits.
+    constexpr bool duelsAgree(Kind first) {
+        for (int second = 0; second < 4; ++second) {
+            for (double apart: {0.0, 0.5, 3.0, 9.9, 21.25, 40.0}) {
+                Outcome played = duel(first, static_cast<Kind>(second), apart);
+                Outcome resolved = resolvedDuel(first, static_cast<Kind>(second), apart);
+                if (played.winner != resolved.winner || played.rounds != resolved.rounds ||
+                    played.healthFirst != resolved.healthFirst || played.healthSecond != resolved.healthSecond) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static_assert(squareRoot(2.0) == 1.4142135623730951 && squareRoot(0x1p-1074) == 0x1p-537);
+    static_assert(duel(Kind::Cowboy, Kind::Cowboy, 5).winner == Winner::First);
+    static_assert(duelsAgree(Kind::Cowboy), "Endgame's closed form disagrees with a played match");
+    static_assert(duelsAgree(Kind::YoungNinja), "Endgame's closed form disagrees with a played match");
+    static_assert(duelsAgree(Kind::TrainedNinja), "Endgame's closed form disagrees with a played match");
+    static_assert(duelsAgree(Kind::OldNinja), "Endgame's closed form disagrees with a played match");
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_TABLES_H
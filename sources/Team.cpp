@@ -12,7 +12,7 @@ namespace ariel {
     }
 
     void Team::add(Character *c) {
-        team.push_back(c);
+        team.push_back(c, TEAM_FULL);
 
     }
 
@@ -20,6 +20,10 @@ namespace ariel {
     return 0;
     }
 
+    std::uint64_t Team::living() const {
+        return team.mask([](const Character *member) { return member != nullptr && member->isAlive(); });
+    }
+
     void Team::attack(Team *c) {
       
     }
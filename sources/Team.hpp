@@ -5,7 +5,9 @@
 #include "OldNinja.hpp"
 #include "TrainedNinja.hpp"
 #include "Cowboy.hpp"
-#include <vector>
+#include "InlineVector.hpp"
+#include "Limits.hpp"
+#include <cstdint>
 #ifndef COWBOY_VS_NINJA_A_TEAM_H
 #define COWBOY_VS_NINJA_A_TEAM_H
 
@@ -14,10 +16,14 @@ namespace ariel {
     class Team {
         Character *leader;
     public:
-        std::vector<Character*> team;
+        // Members are stored inline, so a team is one block; a team can not
+        // grow past the ten members the rules allow.
+        InlineVector<Character *, MAX_MEMBERS> team;
         Team(Character *leader);// constructor
         virtual void add(Character *c);
         int stillAlive();
+        // Bit i is set while member i is alive.
+        std::uint64_t living() const;
         virtual void attack(Team *c);
         void print();
         virtual ~Team();
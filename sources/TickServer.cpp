@@ -0,0 +1,147 @@
+//
+// Created by avida on 5/26/2023.
+//
+
+#include "TickServer.hpp"
+#include "Volley.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace ariel {
+
+    using Clock = std::chrono::steady_clock;
+
+    namespace {
+        // Picks the previous victim while it lives and remembers whoever was
+        // hit last.
+        struct StickyVictim : NoObserver {
+            const Roster *defenders;
+            int *last;
+
+            int pickVictim(const Roster &side) const {
+                return *last >= 0 && *last < side.size && side.members[(size_t) *last].isAlive() ? *last : -1;
+            }
+
+            void changing(const Roster &side, int member) {
+                if (&side == defenders) {
+                    *last = member;
+                }
+            }
+        };
+    }
+
+    bool TickServer::finish(LiveMatch &match) {
+        if (match.rounds < match.options.maxRounds && match.scenario.first.stillAlive() > 0 &&
+            match.scenario.second.stillAlive() > 0) {
+            return false;
+        }
+        match.finished = true;
+        match.outcome = Match::result(match.scenario, match.rounds);
+        active--;
+        return true;
+    }
+
+    TickServer::TickServer(std::chrono::nanoseconds granularity) : granularity(granularity), origin(Clock::now()) {
+        if (granularity.count() <= 0) {
+            throw std::invalid_argument("the timer wheel needs a positive granularity");
+        }
+    }
+
+    int TickServer::host(const Scenario &scenario, const TickOptions &options) {
+        if (options.period.count() <= 0 || options.budget.count() < 0 || options.recoverAfter < 1) {
+            throw std::invalid_argument("a live match needs a positive period and a non negative budget");
+        }
+        LiveMatch match;
+        match.scenario = scenario;
+        match.options = options;
+        if (match.options.budget.count() == 0) {
+            match.options.budget = options.period / 2;
+        }
+        match.deadline = Clock::now() + options.period;
+        matches.push_back(match);
+        active++;
+        if (!finish(matches.back())) {
+            schedule((int) matches.size() - 1);
+        }
+        return (int) matches.size() - 1;
+    }
+
+    // Due in the first slot that starts at or after the deadline, and never
+    // before the next slot so a tick runs at most once per slot.
+    void TickServer::schedule(int match) {
+        auto offset = matches[(size_t) match].deadline - origin;
+        auto slot = (std::uint64_t) std::max<std::int64_t>(0, (offset + granularity - std::chrono::nanoseconds(1)) / granularity);
+        slot = std::max(slot, current + 1);
+        wheel[slot % WHEEL_SLOTS].push_back(Entry{match, slot});
+    }
+
+    void TickServer::playRound(LiveMatch &match) {
+        Scenario &scenario = match.scenario;
+        if (match.policy == Policy::Exact) {
+            Volley::attack(scenario.first, scenario.second);
+            Volley::attack(scenario.second, scenario.first);
+            match.lastVictims = {-1, -1};
+        } else {
+            StickyVictim first{{}, &scenario.second, &match.lastVictims[0]};
+            Match::attack(scenario.first, scenario.second, first);
+            StickyVictim second{{}, &scenario.first, &match.lastVictims[1]};
+            Match::attack(scenario.second, scenario.first, second);
+        }
+        match.rounds++;
+    }
+
+    void TickServer::tick(LiveMatch &match, Clock::time_point now) {
+        auto started = Clock::now();
+        Policy policy = match.policy;
+        playRound(match);
+        auto spent = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started);
+        match.worst = std::max(match.worst, spent);
+        match.degradedTicks += policy == Policy::Sticky ? 1U : 0U;
+        if (spent > match.options.budget) {
+            match.overruns++;
+            match.policy = Policy::Sticky;
+            match.calm = 0;
+        } else if (match.policy == Policy::Sticky && spent * 2 < match.options.budget &&
+                   ++match.calm >= match.options.recoverAfter) {
+            match.policy = Policy::Exact;
+        }
+        if (finish(match)) {
+            return;
+        }
+        match.deadline += match.options.period;
+        if (now - match.deadline > match.options.period) {
+            match.late++;
+            match.deadline = now + match.options.period;
+        }
+    }
+
+    void TickServer::runFor(std::chrono::nanoseconds duration) {
+        auto end = Clock::now() + duration;
+        while (active > 0) {
+            auto now = Clock::now();
+            auto reached = (std::uint64_t) ((now - origin) / granularity);
+            for (; current <= reached && active > 0; ++current) {
+                due.swap(wheel[current % WHEEL_SLOTS]);
+                for (const Entry &entry: due) {
+                    // Entries a whole lap or more ahead stay where they are.
+                    if (entry.slot > current) {
+                        wheel[current % WHEEL_SLOTS].push_back(entry);
+                        continue;
+                    }
+                    LiveMatch &match = matches[(size_t) entry.match];
+                    tick(match, now);
+                    if (!match.finished) {
+                        schedule(entry.match);
+                    }
+                }
+                due.clear();
+            }
+            if (now >= end) {
+                return;
+            }
+            std::this_thread::sleep_until(std::min(end, origin + granularity * (std::int64_t) current));
+        }
+    }
+
+} // ariel
@@ -0,0 +1,93 @@
+//
+// Created by avida on 5/26/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_TICKSERVER_H
+#define COWBOY_VS_NINJA_A_TICKSERVER_H
+
+#include "Match.hpp"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace ariel {
+
+    // How victims are picked. Exact follows the rules; Sticky keeps attacking
+    // the last victim while it lives instead of searching for the closest
+    // enemy on every attack, which is cheaper but no longer the game.
+    enum class Policy : unsigned char { Exact, Sticky };
+
+    struct TickOptions {
+        std::chrono::nanoseconds period = std::chrono::milliseconds(10);
+        // A tick taking longer switches the match to Sticky; zero means half
+        // the period.
+        std::chrono::nanoseconds budget{0};
+        // Ticks in a row under half the budget before going back to Exact.
+        int recoverAfter = 32;
+        int maxRounds = MAX_ROUNDS;
+    };
+
+    struct LiveMatch {
+        Scenario scenario;
+        TickOptions options;
+        Policy policy = Policy::Exact;
+        std::chrono::steady_clock::time_point deadline;
+        std::array<int, 2> lastVictims{-1, -1};
+        int calm = 0;
+        int rounds = 0;
+        bool finished = false;
+        Outcome outcome{};
+
+        std::uint64_t overruns = 0;
+        // Deadlines missed by more than a whole period; the schedule restarts
+        // from the tick that noticed instead of playing the missed ones.
+        std::uint64_t late = 0;
+        std::uint64_t degradedTicks = 0;
+        std::chrono::nanoseconds worst{0};
+    };
+
+    // Runs many matches on one thread, one round per tick, each on its own
+    // fixed period. Deadlines advance by whole periods from the first one so
+    // the schedule never drifts, and due matches are found with a hashed
+    // timer wheel of WHEEL_SLOTS slots of one granularity each.
+    class TickServer {
+    public:
+        static constexpr size_t WHEEL_SLOTS = 256;
+
+    private:
+        struct Entry {
+            int match;
+            std::uint64_t slot;
+        };
+
+        std::chrono::nanoseconds granularity;
+        std::chrono::steady_clock::time_point origin;
+        std::uint64_t current = 0;
+        std::array<std::vector<Entry>, WHEEL_SLOTS> wheel;
+        std::vector<Entry> due;
+        std::vector<LiveMatch> matches;
+        size_t active = 0;
+
+        void schedule(int match);
+        bool finish(LiveMatch &match);
+        void tick(LiveMatch &match, std::chrono::steady_clock::time_point now);
+
+    public:
+        explicit TickServer(std::chrono::nanoseconds granularity = std::chrono::milliseconds(1));
+
+        // The first tick is due one period from now; a scenario that is
+        // already over finishes at once.
+        int host(const Scenario &scenario, const TickOptions &options = {});
+        const LiveMatch &match(int id) const { return matches.at((size_t) id); }
+        size_t running() const { return active; }
+
+        // Plays every tick that falls due within duration, sleeping between
+        // slots; returns early once every match is over.
+        void runFor(std::chrono::nanoseconds duration);
+        // One round of the match with its current policy.
+        static void playRound(LiveMatch &match);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_TICKSERVER_H
@@ -0,0 +1,125 @@
+//
+// Created by avida on 5/24/2023.
+//
+
+#include "Tracer.hpp"
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace ariel {
+
+    Tracer::Tracer(const TraceOptions &options) : options(options) {
+        if (options.capacity == 0 || options.sampleEvery < 1) {
+            throw std::invalid_argument("a trace needs room for spans and a positive sampling interval");
+        }
+    }
+
+    void Tracer::push(SpanKind kind, std::uint64_t start, std::uint64_t end) {
+        if (!sampled) {
+            return;
+        }
+        // The buffer grows up to capacity as spans come in, so short traces
+        // never pay for the whole of it.
+        Span span{start, end, round, kind, side};
+        if (spans.size() < options.capacity) {
+            spans.push_back(span);
+        } else if (options.mode != TraceMode::Full) {
+            spans[recorded % spans.size()] = span;
+        }
+        recorded++;
+    }
+
+    void Tracer::enter(Phase phase) {
+        if (phase == Phase::Leader || phase == Phase::Victim) {
+            phaseStart = ticks();
+        }
+    }
+
+    void Tracer::leave(Phase phase) {
+        if (phase == Phase::Leader) {
+            push(SpanKind::Leader, phaseStart, ticks());
+        } else if (phase == Phase::Victim) {
+            push(SpanKind::Victim, phaseStart, ticks());
+        }
+    }
+
+    void Tracer::roundStarting(const Scenario & /*scenario*/, int rounds) {
+        round = rounds;
+        sampled = options.mode != TraceMode::Sampled || rounds % options.sampleEvery == 0;
+        roundStart = ticks();
+    }
+
+    void Tracer::roundFinished(const Scenario & /*scenario*/, int /*rounds*/) {
+        side = 0;
+        push(SpanKind::Round, roundStart, ticks());
+        // Attacks played outside a round are always recorded.
+        sampled = true;
+    }
+
+    void Tracer::attackStarting(const Scenario & /*scenario*/, int attacker) {
+        side = (std::uint8_t) attacker;
+        attackStart = ticks();
+    }
+
+    void Tracer::attackFinished(const Scenario & /*scenario*/, int /*attacker*/) {
+        push(SpanKind::Attack, attackStart, ticks());
+    }
+
+    size_t Tracer::count(SpanKind kind) const {
+        size_t total = 0;
+        for (size_t i = 0; i < size(); ++i) {
+            total += spans[i].kind == kind ? 1U : 0U;
+        }
+        return total;
+    }
+
+    static const char *spanName(SpanKind kind) {
+        switch (kind) {
+            case SpanKind::Round: return "round";
+            case SpanKind::Attack: return "attack";
+            case SpanKind::Leader: return "leader election";
+            case SpanKind::Victim: return "victim pick";
+        }
+        return "unknown";
+    }
+
+    // Oldest span first; timestamps are microseconds from the oldest start,
+    // written to the nanosecond.
+    void Tracer::write(std::ostream &out) const {
+        size_t first = options.mode != TraceMode::Full && recorded > spans.size() ? recorded % spans.size() : 0;
+        std::uint64_t origin = UINT64_MAX;
+        for (size_t i = 0; i < size(); ++i) {
+            origin = std::min(origin, spans[i].start);
+        }
+        double rate = ticksPerNanosecond() * 1000;
+        std::ios_base::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":" << dropped() << "},\"traceEvents\":[";
+        for (size_t i = 0; i < size(); ++i) {
+            const Span &span = spans[(first + i) % spans.size()];
+            out << (i == 0 ? "" : ",") << "\n{\"name\":\"" << spanName(span.kind) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << (int) span.side + 1 << ",\"ts\":" << (double) (span.start - origin) / rate
+                << ",\"dur\":" << (double) (span.end - span.start) / rate << ",\"args\":{\"round\":" << span.round
+                << "}}";
+        }
+        out << "\n]}\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    void Tracer::writeFile(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out) {
+            throw std::runtime_error("could not open trace file " + path);
+        }
+        write(out);
+    }
+
+    void Tracer::clear() {
+        spans.clear();
+        recorded = 0;
+    }
+
+} // ariel
@@ -0,0 +1,76 @@
+//
+// Created by avida on 5/24/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_TRACER_H
+#define COWBOY_VS_NINJA_A_TRACER_H
+
+#include "Latency.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ariel {
+
+    enum class SpanKind : unsigned char { Round, Attack, Leader, Victim };
+
+    // Full keeps the first `capacity` spans and drops the rest, Ring keeps the
+    // last `capacity` spans, and Sampled records only every sampleEvery-th
+    // round (into a ring as well).
+    enum class TraceMode : unsigned char { Full, Ring, Sampled };
+
+    struct TraceOptions {
+        size_t capacity = 1 << 20;
+        TraceMode mode = TraceMode::Ring;
+        int sampleEvery = 1;
+    };
+
+    // Match::stepByStep observer that records rounds, attacks, leader elections
+    // and victim picks as spans in a buffer that grows to at most capacity
+    // spans, and writes them as Chrome trace event JSON (chrome://tracing,
+    // ui.perfetto.dev).
+    // Each side of the match shows up as its own thread.
+    class Tracer : public NoObserver {
+        struct Span {
+            std::uint64_t start;
+            std::uint64_t end;
+            std::int32_t round;
+            SpanKind kind;
+            std::uint8_t side;
+        };
+
+        TraceOptions options;
+        std::vector<Span> spans;
+        std::uint64_t recorded = 0;
+        std::int32_t round = 0;
+        std::uint8_t side = 0;
+        bool sampled = true;
+        std::uint64_t phaseStart = 0;
+        std::uint64_t attackStart = 0;
+        std::uint64_t roundStart = 0;
+
+        void push(SpanKind kind, std::uint64_t start, std::uint64_t end);
+
+    public:
+        explicit Tracer(const TraceOptions &options = {});
+
+        void enter(Phase phase);
+        void leave(Phase phase);
+        void roundStarting(const Scenario &scenario, int rounds);
+        void roundFinished(const Scenario &scenario, int rounds);
+        void attackStarting(const Scenario &scenario, int attacker);
+        void attackFinished(const Scenario &scenario, int attacker);
+
+        size_t size() const { return std::min<std::uint64_t>(recorded, spans.size()); }
+        std::uint64_t dropped() const { return recorded - size(); }
+        size_t count(SpanKind kind) const;
+        void write(std::ostream &out) const;
+        void writeFile(const std::string &path) const;
+        void clear();
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_TRACER_H
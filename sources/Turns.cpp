@@ -0,0 +1,119 @@
+//
+// Created by avida on 5/26/2023.
+//
+
+#include "Turns.hpp"
+#include <algorithm>
+#include <new>
+
+namespace ariel {
+
+    // Every frame is carved out of blocks of FRAME_BYTES, which fits a whole
+    // Scenario with room to spare; bigger frames fall back to operator new.
+    static constexpr std::size_t FRAME_BYTES = 2048;
+    static constexpr std::size_t MAX_POOLED = 64;
+
+    namespace {
+        struct FramePool {
+            struct Free {
+                Free *next;
+            };
+            Free *head = nullptr;
+            std::size_t count = 0;
+
+            ~FramePool() {
+                while (head != nullptr) {
+                    ::operator delete(std::exchange(head, head->next));
+                }
+            }
+        };
+
+        thread_local FramePool pool;
+    }
+
+    void *Turns::promise_type::operator new(std::size_t size) {
+        if (size > FRAME_BYTES) {
+            return ::operator new(size);
+        }
+        if (pool.head == nullptr) {
+            return ::operator new(FRAME_BYTES);
+        }
+        pool.count--;
+        return std::exchange(pool.head, pool.head->next);
+    }
+
+    void Turns::promise_type::operator delete(void *frame, std::size_t size) {
+        if (size > FRAME_BYTES || pool.count == MAX_POOLED) {
+            ::operator delete(frame);
+            return;
+        }
+        pool.head = new (frame) FramePool::Free{pool.head};
+        pool.count++;
+    }
+
+    size_t Turns::pooledFrames() {
+        return pool.count;
+    }
+
+    Turns &Turns::operator=(Turns &&other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Turns::~Turns() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool Turns::advance(int halfTurns) {
+        if (handle.done()) {
+            return false;
+        }
+        handle.promise().stride = std::max(halfTurns, 1);
+        handle.resume();
+        return !handle.done();
+    }
+
+    Turns turns(Scenario scenario, int maxRounds) {
+        Turns::promise_type &promise = co_await Turns::Promise{};
+        int rounds = 0;
+        int halfTurns = 0;
+        int side = 0;
+        auto over = [&] {
+            return rounds >= maxRounds || scenario.first.stillAlive() == 0 || scenario.second.stillAlive() == 0;
+        };
+        while (side == 1 || !over()) {
+            TurnView view{&scenario, rounds, side, halfTurns};
+            for (int wanted = promise.stride; wanted > 0;) {
+                if (side == 0) {
+                    if (over()) {
+                        break;
+                    }
+                    Match::attack(scenario.first, scenario.second);
+                } else if (scenario.first.stillAlive() > 0 && scenario.second.stillAlive() > 0) {
+                    Match::attack(scenario.second, scenario.first);
+                } else {
+                    // The first team finished the match; the round still counts.
+                    rounds++;
+                    side = 0;
+                    continue;
+                }
+                view = TurnView{&scenario, rounds, side, ++halfTurns};
+                wanted--;
+                rounds += side;
+                side ^= 1;
+            }
+            if (view.halfTurns > promise.current.halfTurns) {
+                co_yield view;
+            }
+        }
+        promise.outcome = Match::result(scenario, rounds);
+    }
+
+} // ariel
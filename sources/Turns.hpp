@@ -0,0 +1,124 @@
+//
+// Created by avida on 5/26/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_TURNS_H
+#define COWBOY_VS_NINJA_A_TURNS_H
+
+#include "Match.hpp"
+#include <coroutine>
+#include <iterator>
+#include <utility>
+
+namespace ariel {
+
+    // Read-only look at a match between two half-turns. The rosters live in
+    // the generator's frame and are only valid until it is resumed again or
+    // destroyed.
+    struct TurnView {
+        const Scenario *scenario = nullptr;
+        // Round the last attack belonged to and the side that made it, 0 for
+        // the first team.
+        int round = 0;
+        int attacker = 0;
+        // Attacks played so far.
+        int halfTurns = 0;
+
+        const Roster &first() const { return scenario->first; }
+        const Roster &second() const { return scenario->second; }
+    };
+
+    // Lazy match, played one half-turn per resume. advance() asks for several
+    // half-turns before the next view, so a consumer looking at every Nth turn
+    // does not pay for suspending and resuming on the turns in between. They
+    // are still played attack by attack: FastForward loses to stepping on
+    // ordinary formations. Frames come from a per thread pool, so starting a
+    // match allocates nothing once warmed up.
+    class Turns {
+    public:
+        struct promise_type {
+            TurnView current;
+            Outcome outcome{};
+            int stride = 1;
+
+            Turns get_return_object() { return Turns(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            std::suspend_always yield_value(const TurnView &view) noexcept {
+                current = view;
+                return {};
+            }
+            void return_void() noexcept {}
+            void unhandled_exception() { throw; }
+
+            static void *operator new(std::size_t size);
+            static void operator delete(void *frame, std::size_t size);
+        };
+
+        // Hands the coroutine its own promise without suspending.
+        struct Promise {
+            promise_type *promise = nullptr;
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                promise = &handle.promise();
+                return false;
+            }
+            promise_type &await_resume() const noexcept { return *promise; }
+        };
+
+        class iterator {
+            Turns *turns = nullptr;
+
+        public:
+            using value_type = TurnView;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            explicit iterator(Turns *turns) : turns(turns) {}
+            const TurnView &operator*() const { return turns->view(); }
+            const TurnView *operator->() const { return &turns->view(); }
+            iterator &operator++() {
+                turns->next();
+                return *this;
+            }
+            void operator++(int) { ++*this; }
+            bool operator==(std::default_sentinel_t /*end*/) const { return turns->done(); }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+        explicit Turns(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    public:
+        Turns(Turns &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+        Turns &operator=(Turns &&other) noexcept;
+        Turns(const Turns &) = delete;
+        Turns &operator=(const Turns &) = delete;
+        ~Turns();
+
+        // Plays up to the next view; false once the match is over.
+        bool next() { return advance(1); }
+        bool advance(int halfTurns);
+        bool done() const { return handle.done(); }
+        const TurnView &view() const { return handle.promise().current; }
+        // Only meaningful once done().
+        const Outcome &outcome() const { return handle.promise().outcome; }
+
+        iterator begin() {
+            next();
+            return iterator(this);
+        }
+        std::default_sentinel_t end() const { return {}; }
+
+        // Frames kept by the calling thread's pool.
+        static size_t pooledFrames();
+    };
+
+    // Takes the scenario into the frame; the views point at that copy.
+    Turns turns(Scenario scenario, int maxRounds = MAX_ROUNDS);
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_TURNS_H
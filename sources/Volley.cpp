@@ -0,0 +1,86 @@
+//
+// Created by avida on 5/19/2023.
+//
+
+#include "Volley.hpp"
+
+namespace ariel {
+
+    Volley::Volley(const Roster &attackers) : attackers(&attackers) {
+        int count = 0;
+        for (int i = 0; i < attackers.size; ++i) {
+            loadedBefore[(size_t) i] = count;
+            const Fighter &member = attackers.members[(size_t) i];
+            if (member.isAlive() && member.isCowboy() && member.bullets > 0) {
+                loaded[(size_t) count++] = i;
+            }
+        }
+        loadedBefore[(size_t) attackers.size] = count;
+    }
+
+    // Index of the attacker, starting at `from`, whose hit brings the victim to
+    // zero health, or -1 if the victim survives everybody who is left.
+    int Volley::killer(const Fighter &victim, int from) const {
+        int remaining = victim.health;
+        int position = from;
+        for (int i = from; i < attackers->size; ++i) {
+            const Fighter &member = attackers->members[(size_t) i];
+            if (!member.isAlive() || member.isCowboy() || distance(member, victim) >= SLASH_RANGE) {
+                continue;
+            }
+            int shots = bulletsUsed(position, i);
+            if (shots * BULLET_DAMAGE >= remaining) {
+                return loaded[(size_t) (loadedBefore[(size_t) position] + (remaining - 1) / BULLET_DAMAGE)];
+            }
+            remaining -= shots * BULLET_DAMAGE + SLASH_DAMAGE;
+            if (remaining <= 0) {
+                return i;
+            }
+            position = i + 1;
+        }
+        int shots = bulletsUsed(position, attackers->size);
+        if (shots * BULLET_DAMAGE >= remaining) {
+            return loaded[(size_t) (loadedBefore[(size_t) position] + (remaining - 1) / BULLET_DAMAGE)];
+        }
+        return -1;
+    }
+
+    void Volley::attack(Roster &attackers, Roster &defenders) {
+        if (attackers.stillAlive() == 0 || defenders.stillAlive() == 0) {
+            return;
+        }
+        const Fighter &former = attackers.members[(size_t) attackers.leader];
+        if (!former.isAlive()) {
+            attackers.leader = attackers.closestAlive(former.x, former.y);
+        }
+        const Fighter &leader = attackers.members[(size_t) attackers.leader];
+        Volley volley(attackers);
+        int from = 0;
+        while (from < attackers.size) {
+            int target = defenders.closestAlive(leader.x, leader.y);
+            if (target < 0) {
+                return;
+            }
+            Fighter &victim = defenders.members[(size_t) target];
+            int last = volley.killer(victim, from);
+            int end = last < 0 ? attackers.size : last + 1;
+            int damage = volley.bulletsUsed(from, end) * BULLET_DAMAGE;
+            for (int i = from; i < end; ++i) {
+                Fighter &member = attackers.members[(size_t) i];
+                if (!member.isAlive()) {
+                    continue;
+                }
+                if (member.isCowboy()) {
+                    member.bullets = member.bullets > 0 ? member.bullets - 1 : COWBOY_BULLETS;
+                } else if (distance(member, victim) < SLASH_RANGE) {
+                    damage += SLASH_DAMAGE;
+                } else {
+                    moveTowards(member, victim, speedOf(member.kind));
+                }
+            }
+            victim.health -= damage;
+            from = end;
+        }
+    }
+
+} // ariel
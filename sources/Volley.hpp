@@ -0,0 +1,33 @@
+//
+// Created by avida on 5/19/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_VOLLEY_H
+#define COWBOY_VS_NINJA_A_VOLLEY_H
+
+#include "Match.hpp"
+
+namespace ariel {
+
+    // Resolves an attack victim by victim instead of attacker by attacker. The
+    // loaded cowboys are ranked once per attack, so finding the attacker that
+    // lands the killing blow only walks the ninjas that are in slashing range
+    // of the victim and jumps over runs of cowboys by division. Ranking costs
+    // more than it saves with at most MAX_MEMBERS attackers, so Match::play
+    // only uses it when MatchOptions::resolveVolleys asks for it.
+    class Volley {
+        std::array<int, MAX_MEMBERS + 1> loadedBefore{};
+        std::array<int, MAX_MEMBERS> loaded{};
+        const Roster *attackers;
+
+    public:
+        explicit Volley(const Roster &attackers);
+        int killer(const Fighter &victim, int from) const;
+        int bulletsUsed(int from, int to) const { return loadedBefore[(size_t) to] - loadedBefore[(size_t) from]; }
+
+        static void attack(Roster &attackers, Roster &defenders);
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_VOLLEY_H
@@ -0,0 +1,79 @@
+//
+// Created by avida on 5/18/2023.
+//
+
+#include "Zobrist.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace ariel {
+
+    static std::uint64_t scramble(std::uint64_t value) {
+        value += 0x9e3779b97f4a7c15ULL;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    static std::uint64_t slotKey(int side, int slot, std::uint64_t field) {
+        return scramble(((std::uint64_t) side << 8 | (std::uint64_t) slot) << 8 | field);
+    }
+
+    const std::uint64_t Zobrist::SIDE_TO_MOVE = scramble(0x5a0b815dULL);
+
+    std::uint64_t Zobrist::member(int side, int slot, const Fighter &fighter) {
+        std::uint64_t key = slotKey(side, slot, 1 + (std::uint64_t) fighter.kind);
+        key = scramble(key ^ (std::uint32_t) fighter.health);
+        key = scramble(key ^ (std::uint64_t) (std::uint32_t) fighter.bullets << 32);
+        key = scramble(key ^ std::bit_cast<std::uint64_t>(fighter.x));
+        key = scramble(key ^ std::bit_cast<std::uint64_t>(fighter.y));
+        return key;
+    }
+
+    std::uint64_t Zobrist::leader(int side, int slot) {
+        return slotKey(side, slot, 0);
+    }
+
+    std::uint64_t Zobrist::hash(const Scenario &scenario) {
+        std::uint64_t value = 0;
+        int side = 0;
+        for (const Roster *roster: {&scenario.first, &scenario.second}) {
+            for (int i = 0; i < roster->size; ++i) {
+                value ^= member(side, i, roster->members[(size_t) i]);
+            }
+            value ^= leader(side, roster->leader);
+            side++;
+        }
+        return value;
+    }
+
+    TranspositionTable::TranspositionTable(size_t capacity)
+            : entries(new Entry[std::bit_ceil(std::max<size_t>(capacity, 1))]),
+              mask(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1) {
+    }
+
+    void TranspositionTable::store(std::uint64_t hash, std::uint64_t data) {
+        Entry &entry = entries[hash & mask];
+        entry.check.store(hash ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+    bool TranspositionTable::probe(std::uint64_t hash, std::uint64_t &data) const {
+        const Entry &entry = entries[hash & mask];
+        std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+        std::uint64_t stored = entry.data.load(std::memory_order_relaxed);
+        if ((check ^ stored) != hash) {
+            return false;
+        }
+        data = stored;
+        return true;
+    }
+
+    void TranspositionTable::clear() {
+        for (size_t i = 0; i <= mask; ++i) {
+            entries[i].check.store(0, std::memory_order_relaxed);
+            entries[i].data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+} // ariel
@@ -0,0 +1,74 @@
+//
+// Created by avida on 5/18/2023.
+//
+
+#ifndef COWBOY_VS_NINJA_A_ZOBRIST_H
+#define COWBOY_VS_NINJA_A_ZOBRIST_H
+
+#include "Match.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ariel {
+
+    // Zobrist style hash of a pair of rosters. The hash is the XOR of one key per
+    // member (side, slot, kind, health, bullets and position), one key per leader
+    // and SIDE_TO_MOVE when the second roster attacks next. Keys are derived from
+    // a fixed mixing function instead of random tables, so health and positions
+    // need no bounded range.
+    class Zobrist {
+    public:
+        static const std::uint64_t SIDE_TO_MOVE;
+
+        static std::uint64_t member(int side, int slot, const Fighter &fighter);
+        static std::uint64_t leader(int side, int slot);
+        static std::uint64_t hash(const Scenario &scenario);
+    };
+
+    // Observer for Match::attack that keeps the hash of a scenario up to date,
+    // XORing a member key out before every change and back in after it.
+    class ZobristObserver : public NoObserver {
+        const Scenario *scenario;
+        std::uint64_t current;
+
+        int side(const Roster &roster) const { return &roster == &scenario->first ? 0 : 1; }
+
+    public:
+        explicit ZobristObserver(const Scenario &scenario)
+                : scenario(&scenario), current(Zobrist::hash(scenario)) {}
+
+        std::uint64_t value() const { return current; }
+        void toggleSideToMove() { current ^= Zobrist::SIDE_TO_MOVE; }
+
+        void changing(const Roster &roster, int slot) {
+            current ^= Zobrist::member(side(roster), slot, roster.members[(size_t) slot]);
+        }
+        void changed(const Roster &roster, int slot) { changing(roster, slot); }
+        void leaderChanging(const Roster &roster) { current ^= Zobrist::leader(side(roster), roster.leader); }
+        void leaderChanged(const Roster &roster) { leaderChanging(roster); }
+    };
+
+    // Fixed size, lock free transposition table. Each entry stores the hash
+    // XORed with its data next to the data itself, so a torn write by another
+    // thread shows up as a miss instead of returning another state's data.
+    class TranspositionTable {
+        struct Entry {
+            std::atomic<std::uint64_t> check{0};
+            std::atomic<std::uint64_t> data{0};
+        };
+
+        std::unique_ptr<Entry[]> entries;
+        size_t mask;
+
+    public:
+        explicit TranspositionTable(size_t capacity);
+        void store(std::uint64_t hash, std::uint64_t data);
+        bool probe(std::uint64_t hash, std::uint64_t &data) const;
+        void clear();
+        size_t capacity() const { return mask + 1; }
+    };
+
+} // ariel
+
+#endif //COWBOY_VS_NINJA_A_ZOBRIST_H